@@ -60,6 +60,7 @@ typedef enum AstNodeType {
         AstNode_MathMult,
         AstNode_MathDiv,
         AstNode_Assignment,
+        AstNode_Constant,
 
         AstNode_None,
         AstNode_Count = AstNode_None,
@@ -83,8 +84,68 @@ bool AstInit(Ast *ast, gs_Allocator allocator) {
         ast->allocator = allocator;
 }
 
+/*
+  Makes `ast_node' a constant with the value and type the lexer decoded.
+  Returns false, leaving the node a constant without a value, if the token
+  isn't a constant or no type can hold it.
+*/
+bool AstNodeSetConstant(AstNode *ast_node, Token token) {
+        ast_node->type = AstNode_Constant;
+        ast_node->value_type = AstValue_None;
+        ast_node->num_children = 0;
+
+        LexerValue value;
+        if (!LexerDecodeConstant(token, &value) || value.overflow) return false;
+
+        /* The lexer gives an integer a type that holds it, so these casts don't narrow. */
+        switch (value.type) {
+                case LexerValue_Int:
+                case LexerValue_Character: {
+                        ast_node->value_type = AstValue_SignedWord;
+                        ast_node->value.signed_word = (i32)value.as.integer;
+                } break;
+                case LexerValue_UnsignedInt: {
+                        ast_node->value_type = AstValue_UnsignedWord;
+                        ast_node->value.unsigned_word = (u32)value.as.integer;
+                } break;
+                case LexerValue_Long: {
+                        ast_node->value_type = AstValue_SignedLong;
+                        ast_node->value.signed_long = (i64)value.as.integer;
+                } break;
+                case LexerValue_UnsignedLong: {
+                        ast_node->value_type = AstValue_UnsignedLong;
+                        ast_node->value.unsigned_long = value.as.integer;
+                } break;
+                case LexerValue_LongLong: {
+                        ast_node->value_type = AstValue_SignedLongLong;
+                        ast_node->value.signed_long = (i64)value.as.integer;
+                } break;
+                case LexerValue_UnsignedLongLong: {
+                        ast_node->value_type = AstValue_UnsignedLongLong;
+                        ast_node->value.unsigned_long = value.as.integer;
+                } break;
+                case LexerValue_Float: {
+                        ast_node->value_type = AstValue_Floating;
+                        ast_node->value.floating = (f32)value.as.floating;
+                } break;
+                case LexerValue_Double: {
+                        ast_node->value_type = AstValue_DoublePrecision;
+                        ast_node->value.double_precision = value.as.floating;
+                } break;
+                case LexerValue_LongDouble: {
+                        ast_node->value_type = AstValue_QuadPrecision;
+                        ast_node->value.quad_precision = value.as.floating;
+                } break;
+        }
+
+        return true;
+}
+
 bool AstNodeDo(AstNode *ast_node, ParseTreeNode *parse_node) {
         switch (parse_node->type) {
+                case ParseTreeNode_Constant: {
+                        if (!AstNodeSetConstant(ast_node, parse_node->token)) return false;
+                } break;
                 case ParseTreeNode_LogicalAndExpression: {
                         ast_node->type = AstNode_LogicalAnd;
                         ast_node->value_type = AstValue_None;
@@ -97,6 +158,8 @@ bool AstNodeDo(AstNode *ast_node, ParseTreeNode *parse_node) {
                         */
                 } break;
         }
+
+        return true;
 }
 
 #endif /* AST_C */
@@ -114,6 +114,120 @@ void gs_MemSet(char *mem, char byte, u32 size) {
         }
 }
 
+void gs_MemCopy(void *source, void *dest, u64 size) {
+        u8 *from = (u8 *)source;
+        u8 *to = (u8 *)dest;
+        for (u64 i = 0; i < size; i++) {
+                to[i] = from[i];
+        }
+}
+
+/******************************************************************************
+ * Arena
+ *-----------------------------------------------------------------------------
+ * Bump allocator over a chain of blocks taken from a backing allocator.
+ * Individual frees do nothing; gs_ArenaDeinit releases everything at once.
+ * Allocations are 8-byte aligned.
+ ******************************************************************************/
+
+typedef struct gs_ArenaBlock {
+        struct gs_ArenaBlock *previous;
+        u64 capacity;
+        u64 used;
+} gs_ArenaBlock;
+
+typedef struct gs_Arena {
+        gs_Allocator backing;
+        gs_ArenaBlock *block;
+        u64 block_size;
+} gs_Arena;
+
+#define __GS_ARENA_ALIGN(Size) (((Size) + 7) & ~(u64)7)
+
+void gs_ArenaInit(gs_Arena *arena, gs_Allocator backing, u64 block_size) {
+        arena->backing = backing;
+        arena->block = GS_NULL_PTR;
+        arena->block_size = block_size;
+}
+
+/*
+  Each allocation is preceded by its size so realloc knows how much to copy.
+*/
+void *gs_ArenaAlloc(gs_Arena *arena, u64 size) {
+        u64 needed = sizeof(u64) + __GS_ARENA_ALIGN(size);
+        gs_ArenaBlock *block = arena->block;
+
+        if (block == GS_NULL_PTR || block->used + needed > block->capacity) {
+                u64 capacity = gs_Max(arena->block_size, needed);
+                block = (gs_ArenaBlock *)arena->backing.malloc(sizeof(gs_ArenaBlock) + capacity);
+                if (block == GS_NULL_PTR) return GS_NULL_PTR;
+
+                block->previous = arena->block;
+                block->capacity = capacity;
+                block->used = 0;
+                arena->block = block;
+        }
+
+        u8 *memory = (u8 *)(block + 1) + block->used;
+        block->used += needed;
+
+        *(u64 *)memory = size;
+        return memory + sizeof(u64);
+}
+
+void *gs_ArenaRealloc(gs_Arena *arena, void *ptr, u64 size) {
+        void *result = gs_ArenaAlloc(arena, size);
+        if (result == GS_NULL_PTR || ptr == GS_NULL_PTR) return result;
+
+        u64 old_size = *((u64 *)ptr - 1);
+        gs_MemCopy(ptr, result, gs_Min(old_size, size));
+
+        return result;
+}
+
+bool gs_ArenaOwns(gs_Arena *arena, void *ptr) {
+        for (gs_ArenaBlock *block = arena->block; block != GS_NULL_PTR; block = block->previous) {
+                u8 *start = (u8 *)(block + 1);
+                if ((u8 *)ptr >= start && (u8 *)ptr < start + block->used) return true;
+        }
+        return false;
+}
+
+/*
+  A mark records the arena's high-water position. Rolling back to it releases
+  everything allocated since in O(1) per block; pointers into that memory
+  become invalid.
+*/
+typedef struct gs_ArenaMark {
+        gs_ArenaBlock *block;
+        u64 used;
+} gs_ArenaMark;
+
+gs_ArenaMark gs_ArenaGetMark(gs_Arena *arena) {
+        gs_ArenaMark mark = { .block = arena->block, .used = 0 };
+        if (arena->block != GS_NULL_PTR) mark.used = arena->block->used;
+        return mark;
+}
+
+void gs_ArenaRollback(gs_Arena *arena, gs_ArenaMark mark) {
+        while (arena->block != mark.block) {
+                gs_ArenaBlock *previous = arena->block->previous;
+                arena->backing.free(arena->block);
+                arena->block = previous;
+        }
+        if (arena->block != GS_NULL_PTR) arena->block->used = mark.used;
+}
+
+void gs_ArenaDeinit(gs_Arena *arena) {
+        gs_ArenaBlock *block = arena->block;
+        while (block != GS_NULL_PTR) {
+                gs_ArenaBlock *previous = block->previous;
+                arena->backing.free(block);
+                block = previous;
+        }
+        arena->block = GS_NULL_PTR;
+}
+
 /******************************************************************************
  * Character Definitions
  *-----------------------------------------------------------------------------
@@ -700,6 +814,8 @@ bool gs_BufferRestoreCursor(gs_Buffer *buffer) {
 typedef struct gs_TreeNode {
         struct gs_TreeNode *child;
         struct gs_TreeNode *sibling;
+        struct gs_TreeNode *last_child; /* Tail of the child list, so appends are O(1). */
+        u32 num_children;
 } gs_TreeNode;
 
 // Gets the containing struct of this gs_TreeNode instance.
@@ -721,9 +837,10 @@ typedef struct gs_TreeNode {
 #define gs_TreeDeinit(node, type, member, deinit)       \
         __gs_TreeDeinit(node, offsetof(type, member), deinit)
 
+// Gets the num'th child (counting from 0) of ptr, which must have more than num children.
 #define gs_TreeChildAt(ptr, type, member, num)          \
         ({                                              \
-                gs_TreeNode *node = &(ptr->member);     \
+                gs_TreeNode *node = (ptr->member).child; \
                 for (int i = 0; i < num; ++i) {         \
                         node = node->sibling;           \
                 }                                       \
@@ -733,44 +850,78 @@ typedef struct gs_TreeNode {
 void gs_TreeInit(gs_TreeNode *tree, gs_Allocator allocator) {
         tree->child = GS_NULL_PTR;
         tree->sibling = GS_NULL_PTR;
+        tree->last_child = GS_NULL_PTR;
+        tree->num_children = 0;
 }
 
-gs_TreeNode *__gs_TreeAddChild(gs_TreeNode *node, u32 size, u32 offset, gs_Allocator allocator) {
-        gs_TreeNode *cur;
-
-        if (node->child == GS_NULL_PTR) {
-                cur = node;
-                u8 *mem = allocator.malloc(size);
-                cur->child = (gs_TreeNode *)(mem + offset);
-                // TODO: Error handling
-                gs_TreeInit(cur->child, allocator);
-                return cur->child;
+u32 gs_TreeNumChildren(gs_TreeNode *tree) {
+        return tree->num_children;
+}
+
+// Forgets tree's children without freeing them.
+void gs_TreeDetachChildren(gs_TreeNode *tree) {
+        tree->child = GS_NULL_PTR;
+        tree->last_child = GS_NULL_PTR;
+        tree->num_children = 0;
+}
+
+// Moves source's children to dest, replacing any children dest had.
+void gs_TreeMoveChildren(gs_TreeNode *dest, gs_TreeNode *source) {
+        dest->child = source->child;
+        dest->last_child = source->last_child;
+        dest->num_children = source->num_children;
+        gs_TreeDetachChildren(source);
+}
+
+// Links an existing, detached node in as tree's last child.
+void gs_TreeAppendChild(gs_TreeNode *tree, gs_TreeNode *child) {
+        child->sibling = GS_NULL_PTR;
+
+        if (tree->child == GS_NULL_PTR) {
+                tree->child = child;
         } else {
-                cur = node->child;
-                while (cur->sibling != GS_NULL_PTR) {
-                        cur = cur->sibling;
-                }
+                tree->last_child->sibling = child;
+        }
+        tree->last_child = child;
+        tree->num_children++;
+}
 
-                u8 *mem = allocator.malloc(size);
-                // TODO: Error handling
-                cur->sibling = (gs_TreeNode *)(mem + offset);
-                gs_TreeInit(cur->sibling, allocator);
-                return cur->sibling;
+// Links source's children in after dest's own, leaving source pointing at them
+// too. Whatever followed source's last child is cut off.
+void gs_TreeShareChildren(gs_TreeNode *dest, gs_TreeNode *source) {
+        if (source->child == GS_NULL_PTR) return;
+
+        source->last_child->sibling = GS_NULL_PTR;
+        if (dest->child == GS_NULL_PTR) {
+                dest->child = source->child;
+        } else {
+                dest->last_child->sibling = source->child;
+        }
+        dest->last_child = source->last_child;
+        dest->num_children += source->num_children;
+}
+
+gs_TreeNode *__gs_TreeAddChild(gs_TreeNode *node, u32 size, u32 offset, gs_Allocator allocator) {
+        u8 *mem = allocator.malloc(size);
+        if (mem == GS_NULL_PTR) {
+                return GS_NULL_PTR;
         }
 
-        return GS_NULL_PTR;
+        gs_TreeNode *child = (gs_TreeNode *)(mem + offset);
+        gs_TreeInit(child, allocator);
+        gs_TreeAppendChild(node, child);
+
+        return child;
 }
 
 void __gs_TreeDeinit(gs_TreeNode *node, u32 offset, void (*deinit)(void *)) {
-        if (node->child != GS_NULL_PTR) {
-                __gs_TreeDeinit(node->child, offset, deinit);
-        }
-        if (node->sibling != GS_NULL_PTR) {
-                __gs_TreeDeinit(node->sibling, offset, deinit);
-        }
-        if (node->child == GS_NULL_PTR && node->sibling == GS_NULL_PTR) {
-                deinit((u8 *)node - offset);
+        gs_TreeNode *child = node->child;
+        while (child != GS_NULL_PTR) {
+                gs_TreeNode *sibling = child->sibling;
+                __gs_TreeDeinit(child, offset, deinit);
+                child = sibling;
         }
+        deinit((u8 *)node - offset);
 }
 
 #endif /* GS_VERSION */
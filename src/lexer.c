@@ -13,10 +13,22 @@
 
 #include "gs.h"
 
+#include <pthread.h>
+#include <stdlib.h> /* strtod */
+#include <string.h> /* memchr, memcpy, memmove */
+#include <unistd.h> /* sysconf */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 typedef enum LexerErrorEnum {
         LexerErrorNoSpace,
         LexerReallocFail,
         LexerUnknownToken,
+        LexerErrorNoLineSpace,
         LexerErrorNone,
 } LexerErrorEnum;
 
@@ -24,14 +36,27 @@ const char *__lexer_error_strings[] = {
         "Couldn't allocate space for token stream",
         "Couldn't reallocate space for token stream after lexing completed",
         "Unknown token",
+        "Couldn't allocate space for line index",
         "No error",
 };
 
-LexerErrorEnum __lexer_last_error = LexerErrorNone;
+/*
+  What a caller lexes with: the allocator and where errors are reported.
+  Lexes with different contexts share no state, so they can run at once.
+*/
+typedef struct LexerContext {
+        gs_Allocator allocator;
+        LexerErrorEnum last_error;
+} LexerContext;
+
+void LexerContextInit(LexerContext *context, gs_Allocator allocator) {
+        context->allocator = allocator;
+        context->last_error = LexerErrorNone;
+}
 
-const char *LexerErrorString() {
-        const char *result = __lexer_error_strings[__lexer_last_error];
-        __lexer_last_error = LexerErrorNone;
+const char *LexerErrorString(LexerContext *context) {
+        const char *result = __lexer_error_strings[context->last_error];
+        context->last_error = LexerErrorNone;
         return result;
 }
 
@@ -90,7 +115,38 @@ typedef enum TokenType {
         Token_Character,
         Token_String,
         Token_Identifier,
-        Token_Keyword,
+        Token_KeywordAuto,
+        Token_KeywordBreak,
+        Token_KeywordCase,
+        Token_KeywordChar,
+        Token_KeywordConst,
+        Token_KeywordContinue,
+        Token_KeywordDefault,
+        Token_KeywordDo,
+        Token_KeywordDouble,
+        Token_KeywordElse,
+        Token_KeywordEnum,
+        Token_KeywordExtern,
+        Token_KeywordFloat,
+        Token_KeywordFor,
+        Token_KeywordGoto,
+        Token_KeywordIf,
+        Token_KeywordInt,
+        Token_KeywordLong,
+        Token_KeywordRegister,
+        Token_KeywordReturn,
+        Token_KeywordShort,
+        Token_KeywordSigned,
+        Token_KeywordSizeof,
+        Token_KeywordStatic,
+        Token_KeywordStruct,
+        Token_KeywordSwitch,
+        Token_KeywordTypedef,
+        Token_KeywordUnion,
+        Token_KeywordUnsigned,
+        Token_KeywordVoid,
+        Token_KeywordVolatile,
+        Token_KeywordWhile,
         Token_PreprocessorCommand,
         Token_Comment,
         Token_Integer,
@@ -155,6 +211,37 @@ char *__lexer_token_type_names[] = {
         "String",
         "Identifier",
         "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
+        "Keyword",
         "PreprocessorCommand",
         "Comment",
         "Integer",
@@ -167,43 +254,513 @@ char *TokenName(TokenType type) {
         return __lexer_token_type_names[type];
 }
 
+#define LEXER_NO_SYMBOL 0xFFFFFFFF
+
 typedef struct Token {
         char *text;
         u32 text_length;
         TokenType type;
-        u32 line;
-        u32 column;
+        u32 symbol; /* Interned name of an identifier, or LEXER_NO_SYMBOL. */
 } Token;
 
+/*
+  Interned identifier names. Each distinct name gets a dense ID in the order it
+  is first seen, so symbol tables and indexes can key on integers. The table
+  keeps its own copy of every name and may be shared by any number of lexes,
+  but not by lexes running at the same time.
+*/
+typedef struct LexerSymbols {
+        gs_Allocator allocator;
+
+        u32 *slots; /* Open addressing over name hashes; symbol + 1, or 0 if empty. */
+        u32 num_slots; /* A power of two. */
+
+        char *text; /* NUL-terminated names, back to back. */
+        u64 text_length;
+        u64 text_capacity;
+
+        /* By symbol. */
+        u64 *name_offset;
+        u32 *name_length;
+        u32 *name_hash;
+        u32 num_symbols;
+        u32 capacity;
+} LexerSymbols;
+
+#define LEXER_SYMBOLS_INITIAL_CAPACITY 256
+
+bool LexerSymbolsInit(LexerSymbols *symbols, gs_Allocator allocator) {
+        symbols->allocator = allocator;
+        symbols->num_slots = LEXER_SYMBOLS_INITIAL_CAPACITY * 2;
+        symbols->slots = (u32 *)allocator.calloc(symbols->num_slots, sizeof(*symbols->slots));
+        symbols->text_length = 0;
+        symbols->text_capacity = LEXER_SYMBOLS_INITIAL_CAPACITY * 8;
+        symbols->text = (char *)allocator.malloc(symbols->text_capacity);
+        symbols->num_symbols = 0;
+        symbols->capacity = LEXER_SYMBOLS_INITIAL_CAPACITY;
+        symbols->name_offset = (u64 *)allocator.malloc(sizeof(*symbols->name_offset) * symbols->capacity);
+        symbols->name_length = (u32 *)allocator.malloc(sizeof(*symbols->name_length) * symbols->capacity);
+        symbols->name_hash = (u32 *)allocator.malloc(sizeof(*symbols->name_hash) * symbols->capacity);
+
+        if (symbols->slots == GS_NULL_PTR || symbols->text == GS_NULL_PTR || symbols->name_offset == GS_NULL_PTR ||
+            symbols->name_length == GS_NULL_PTR || symbols->name_hash == GS_NULL_PTR) {
+                if (symbols->slots != GS_NULL_PTR) allocator.free(symbols->slots);
+                if (symbols->text != GS_NULL_PTR) allocator.free(symbols->text);
+                if (symbols->name_offset != GS_NULL_PTR) allocator.free(symbols->name_offset);
+                if (symbols->name_length != GS_NULL_PTR) allocator.free(symbols->name_length);
+                if (symbols->name_hash != GS_NULL_PTR) allocator.free(symbols->name_hash);
+                symbols->slots = GS_NULL_PTR;
+                return false;
+        }
+
+        return true;
+}
+
+void LexerSymbolsDeinit(LexerSymbols *symbols) {
+        if (symbols->slots == GS_NULL_PTR) return;
+        symbols->allocator.free(symbols->slots);
+        symbols->allocator.free(symbols->text);
+        symbols->allocator.free(symbols->name_offset);
+        symbols->allocator.free(symbols->name_length);
+        symbols->allocator.free(symbols->name_hash);
+        symbols->slots = GS_NULL_PTR;
+        symbols->num_symbols = 0;
+}
+
+/* FNV-1a. */
+u32 __lexer_SymbolHash(char *text, u32 length) {
+        u32 hash = 2166136261u;
+        for (u32 i = 0; i < length; i++) {
+                hash = (hash ^ (u8)text[i]) * 16777619u;
+        }
+        return hash;
+}
+
+/* Returns the slot holding `text', or the empty slot where it belongs. */
+u32 *__lexer_SymbolSlot(LexerSymbols *symbols, char *text, u32 length, u32 hash) {
+        u32 mask = symbols->num_slots - 1;
+        for (u32 i = hash & mask; ; i = (i + 1) & mask) {
+                u32 *slot = &symbols->slots[i];
+                if (*slot == 0) return slot;
+
+                u32 symbol = *slot - 1;
+                if (symbols->name_hash[symbol] == hash && symbols->name_length[symbol] == length &&
+                    gs_StringIsEqual(symbols->text + symbols->name_offset[symbol], text, length)) {
+                        return slot;
+                }
+        }
+}
+
+/* Doubles the slot array, keeping it at most half full. */
+bool __lexer_SymbolsRehash(LexerSymbols *symbols) {
+        u32 num_slots = symbols->num_slots * 2;
+        u32 *slots = (u32 *)symbols->allocator.calloc(num_slots, sizeof(*slots));
+        if (slots == GS_NULL_PTR) return false;
+
+        for (u32 symbol = 0; symbol < symbols->num_symbols; symbol++) {
+                u32 i = symbols->name_hash[symbol] & (num_slots - 1);
+                while (slots[i] != 0) i = (i + 1) & (num_slots - 1);
+                slots[i] = symbol + 1;
+        }
+
+        symbols->allocator.free(symbols->slots);
+        symbols->slots = slots;
+        symbols->num_slots = num_slots;
+        return true;
+}
+
+/* Returns the symbol for `text', or LEXER_NO_SYMBOL if it was never interned. */
+u32 LexerSymbolsFind(LexerSymbols *symbols, char *text, u32 length) {
+        u32 *slot = __lexer_SymbolSlot(symbols, text, length, __lexer_SymbolHash(text, length));
+        return (*slot == 0) ? LEXER_NO_SYMBOL : *slot - 1;
+}
+
+/* Returns the symbol for `text', adding it if it is new; LEXER_NO_SYMBOL if out of memory. */
+u32 LexerSymbolsIntern(LexerSymbols *symbols, char *text, u32 length) {
+        u32 hash = __lexer_SymbolHash(text, length);
+        u32 *slot = __lexer_SymbolSlot(symbols, text, length, hash);
+        if (*slot != 0) return *slot - 1;
+
+        gs_Allocator allocator = symbols->allocator;
+        if (symbols->num_symbols == symbols->capacity) {
+                u32 capacity = symbols->capacity * 2;
+                u64 *name_offset = (u64 *)allocator.realloc(symbols->name_offset, sizeof(*name_offset) * capacity);
+                if (name_offset == GS_NULL_PTR) return LEXER_NO_SYMBOL;
+                symbols->name_offset = name_offset;
+                u32 *name_length = (u32 *)allocator.realloc(symbols->name_length, sizeof(*name_length) * capacity);
+                if (name_length == GS_NULL_PTR) return LEXER_NO_SYMBOL;
+                symbols->name_length = name_length;
+                u32 *name_hash = (u32 *)allocator.realloc(symbols->name_hash, sizeof(*name_hash) * capacity);
+                if (name_hash == GS_NULL_PTR) return LEXER_NO_SYMBOL;
+                symbols->name_hash = name_hash;
+                symbols->capacity = capacity;
+        }
+
+        if (symbols->text_length + length + 1 > symbols->text_capacity) {
+                u64 text_capacity = gs_Max(symbols->text_capacity * 2, symbols->text_length + length + 1);
+                char *text_grown = (char *)allocator.realloc(symbols->text, text_capacity);
+                if (text_grown == GS_NULL_PTR) return LEXER_NO_SYMBOL;
+                symbols->text = text_grown;
+                symbols->text_capacity = text_capacity;
+        }
+
+        if ((symbols->num_symbols + 1) * 2 > symbols->num_slots) {
+                if (!__lexer_SymbolsRehash(symbols)) return LEXER_NO_SYMBOL;
+                slot = __lexer_SymbolSlot(symbols, text, length, hash);
+        }
+
+        u32 symbol = symbols->num_symbols++;
+        symbols->name_offset[symbol] = symbols->text_length;
+        symbols->name_length[symbol] = length;
+        symbols->name_hash[symbol] = hash;
+        gs_MemCopy(text, symbols->text + symbols->text_length, length);
+        symbols->text[symbols->text_length + length] = '\0';
+        symbols->text_length += length + 1;
+        *slot = symbol + 1;
+
+        return symbol;
+}
+
+/* The NUL-terminated name of `symbol'. */
+char *LexerSymbolsName(LexerSymbols *symbols, u32 symbol, u32 *out_length) {
+        if (out_length != GS_NULL_PTR) *out_length = symbols->name_length[symbol];
+        return symbols->text + symbols->name_offset[symbol];
+}
+
+/*
+  The value of an integer, floating or character constant, decoded once by the
+  lexer so consumers don't re-parse the digits. An integer's type is the first
+  its suffix and radix allow that holds its value, as C gives it; a floating
+  constant's is the one its suffix names. Floating values are kept as the
+  nearest double whatever their type.
+*/
+typedef enum LexerValueType {
+        LexerValue_Int,
+        LexerValue_UnsignedInt,
+        LexerValue_Long,
+        LexerValue_UnsignedLong,
+        LexerValue_LongLong,
+        LexerValue_UnsignedLongLong,
+        LexerValue_Double,
+        LexerValue_Float,
+        LexerValue_LongDouble,
+        LexerValue_Character,
+} LexerValueType;
+
+typedef struct LexerValue {
+        union {
+                u64 integer;
+                f64 floating;
+        } as;
+        u8 type; /* LexerValueType */
+        u8 radix; /* 8, 10 or 16 for integers; 10 otherwise. */
+        bool overflow; /* An integer too large for any type it may have; `as.integer' holds its low 64 bits. */
+} LexerValue;
+
+/*
+  Compact token stream in structure-of-arrays form: a byte for each token's
+  type, its text as a 32-bit offset and length into `source', and a 32-bit
+  payload. That is thirteen bytes a token against sizeof(Token), and rules that
+  only look at types walk a dense byte array.
+
+  Decoded constants live in a side table in token order; a constant's payload
+  is its entry there, so finding its value is one load.
+*/
+typedef struct TokenStream {
+        char *source;
+        u8 *kind; /* TokenType; every type fits in a byte. */
+        u32 *offset;
+        u32 *length;
+        u32 *payload; /* An identifier's symbol, a constant's value entry, or LEXER_NO_SYMBOL. */
+        u32 num_tokens;
+        LexerSymbols *symbols; /* What `symbol' indexes; null if identifiers aren't interned. */
+        bool recovering; /* Lexed with diagnostics, so error tokens can come anywhere, not just last. */
+
+        u32 *value_token; /* The token each value belongs to. */
+        LexerValue *value;
+        u32 num_values;
+        u32 values_capacity;
+
+        gs_Allocator allocator;
+} TokenStream;
+
+Token TokenStreamGet(TokenStream *stream, u32 index) {
+        Token token;
+        token.text = stream->source + stream->offset[index];
+        token.text_length = stream->length[index];
+        token.type = (TokenType)stream->kind[index];
+        token.symbol = (token.type == Token_Identifier) ? stream->payload[index] : LEXER_NO_SYMBOL;
+        return token;
+}
+
+void TokenStreamDeinit(TokenStream *stream) {
+        if (stream->kind != GS_NULL_PTR) stream->allocator.free(stream->kind);
+        if (stream->offset != GS_NULL_PTR) stream->allocator.free(stream->offset);
+        if (stream->length != GS_NULL_PTR) stream->allocator.free(stream->length);
+        if (stream->payload != GS_NULL_PTR) stream->allocator.free(stream->payload);
+        if (stream->value_token != GS_NULL_PTR) stream->allocator.free(stream->value_token);
+        if (stream->value != GS_NULL_PTR) stream->allocator.free(stream->value);
+        stream->kind = GS_NULL_PTR;
+        stream->offset = stream->length = stream->payload = stream->value_token = GS_NULL_PTR;
+        stream->value = GS_NULL_PTR;
+        stream->num_tokens = stream->num_values = stream->values_capacity = 0;
+}
+
+/* The first side table entry for a token at or after `index'. */
+u32 __lexer_TokenStreamValueAt(TokenStream *stream, u32 index) {
+        u32 low = 0, high = stream->num_values;
+        while (low < high) {
+                u32 middle = low + (high - low) / 2;
+                if (stream->value_token[middle] < index) low = middle + 1;
+                else high = middle;
+        }
+        return low;
+}
+
+/* Looks up the decoded value of the constant at `index'; false if it isn't a constant. */
+bool TokenStreamValue(TokenStream *stream, u32 index, LexerValue *out_value) {
+        TokenType type = (TokenType)stream->kind[index];
+        bool is_constant = type == Token_Integer || type == Token_PrecisionNumber || type == Token_Character;
+        if (!is_constant || stream->payload[index] == LEXER_NO_SYMBOL) return false;
+        *out_value = stream->value[stream->payload[index]];
+        return true;
+}
+
+/*
+  Comments and directive lines, which GetToken skips, kept for callers such as
+  formatters that want them. Each entry records the token it precedes by that
+  token's offset, so a token's leading trivia is a binary search away in
+  either token layout. Offsets are relative to the tokenizer's beginning.
+*/
+typedef struct LexerTrivia {
+        u8 *kind; /* Token_Comment or Token_PreprocessorCommand. */
+        u32 *offset;
+        u32 *length;
+        u32 *token_offset; /* Offset of the token that follows. */
+        u32 num_trivia;
+        u32 capacity;
+        bool out_of_memory; /* An entry was dropped. */
+        gs_Allocator allocator;
+} LexerTrivia;
+
+void LexerTriviaInit(LexerTrivia *trivia, gs_Allocator allocator) {
+        trivia->kind = GS_NULL_PTR;
+        trivia->offset = trivia->length = trivia->token_offset = GS_NULL_PTR;
+        trivia->num_trivia = trivia->capacity = 0;
+        trivia->out_of_memory = false;
+        trivia->allocator = allocator;
+}
+
+void LexerTriviaDeinit(LexerTrivia *trivia) {
+        if (trivia->kind != GS_NULL_PTR) trivia->allocator.free(trivia->kind);
+        if (trivia->offset != GS_NULL_PTR) trivia->allocator.free(trivia->offset);
+        if (trivia->length != GS_NULL_PTR) trivia->allocator.free(trivia->length);
+        if (trivia->token_offset != GS_NULL_PTR) trivia->allocator.free(trivia->token_offset);
+        LexerTriviaInit(trivia, trivia->allocator);
+}
+
+bool __lexer_TriviaGrow(LexerTrivia *trivia) {
+        gs_Allocator allocator = trivia->allocator;
+        u32 capacity = (trivia->capacity > 0) ? trivia->capacity * 2 : 256;
+
+        u8 *kind = (u8 *)allocator.realloc(trivia->kind, sizeof(*kind) * (u64)capacity);
+        if (kind == GS_NULL_PTR) return false;
+        trivia->kind = kind;
+
+        u32 *offset = (u32 *)allocator.realloc(trivia->offset, sizeof(*offset) * (u64)capacity);
+        if (offset == GS_NULL_PTR) return false;
+        trivia->offset = offset;
+
+        u32 *length = (u32 *)allocator.realloc(trivia->length, sizeof(*length) * (u64)capacity);
+        if (length == GS_NULL_PTR) return false;
+        trivia->length = length;
+
+        u32 *token_offset = (u32 *)allocator.realloc(trivia->token_offset, sizeof(*token_offset) * (u64)capacity);
+        if (token_offset == GS_NULL_PTR) return false;
+        trivia->token_offset = token_offset;
+
+        trivia->capacity = capacity;
+        return true;
+}
+
+/* Appends skipped trivia; the token that follows is filled in by __lexer_TriviaAttach. */
+void __lexer_TriviaAdd(LexerTrivia *trivia, char *beginning, Token token) {
+        if (trivia->num_trivia == trivia->capacity && !__lexer_TriviaGrow(trivia)) {
+                trivia->out_of_memory = true;
+                return;
+        }
+
+        u32 entry = trivia->num_trivia++;
+        trivia->kind[entry] = (u8)token.type;
+        trivia->offset[entry] = (u32)(token.text - beginning);
+        trivia->length[entry] = token.text_length;
+}
+
+/* Attaches the trivia recorded since `first' to the token at `token_offset'. */
+void __lexer_TriviaAttach(LexerTrivia *trivia, u32 first, u32 token_offset) {
+        for (u32 i = first; i < trivia->num_trivia; i++) trivia->token_offset[i] = token_offset;
+}
+
+/* Finds the trivia before the token at `token_offset': returns how many entries there are, from `*out_first'. */
+u32 LexerTriviaFind(LexerTrivia *trivia, u32 token_offset, u32 *out_first) {
+        u32 low = 0, high = trivia->num_trivia;
+        while (low < high) {
+                u32 middle = low + (high - low) / 2;
+                if (trivia->token_offset[middle] < token_offset) low = middle + 1;
+                else high = middle;
+        }
+
+        u32 first = low;
+        while (low < trivia->num_trivia && trivia->token_offset[low] == token_offset) low++;
+
+        *out_first = first;
+        return low - first;
+}
+
+/*
+  What an error token (Token_Unknown) in a recovering lex stands for. Each
+  kind's range ends where lexing can sensibly pick up again.
+*/
+typedef enum LexerDiagnosticKind {
+        LexerDiagnostic_StrayCharacter, /* A run of bytes no token starts with. */
+        LexerDiagnostic_BadNumber, /* The rest of the malformed constant. */
+        LexerDiagnostic_BadCharacter, /* Through the closing quote, or to the end of the line. */
+        LexerDiagnostic_UnterminatedString, /* To the end of the line. */
+} LexerDiagnosticKind;
+
+const char *__lexer_diagnostic_strings[] = {
+        "Stray character",
+        "Malformed number",
+        "Malformed character constant",
+        "Unterminated string",
+};
+
+typedef struct LexerDiagnostic {
+        u32 offset; /* Relative to the tokenizer's beginning. */
+        u32 length;
+        u8 kind;
+} LexerDiagnostic;
+
+/*
+  Errors found while lexing with recovery, in input order. The buffer is
+  allocated once, up front: errors past `capacity' are only counted, so an
+  input that is all errors costs no more memory than a clean one.
+*/
+typedef struct LexerDiagnostics {
+        LexerDiagnostic *entries;
+        u32 num_entries;
+        u32 capacity;
+        u32 num_dropped; /* Errors found once the buffer was full. */
+        gs_Allocator allocator;
+} LexerDiagnostics;
+
+bool LexerDiagnosticsInit(LexerDiagnostics *diagnostics, LexerContext *context, u32 capacity) {
+        gs_Allocator allocator = context->allocator;
+        diagnostics->entries = (LexerDiagnostic *)allocator.malloc(sizeof(*diagnostics->entries) * (u64)gs_Max(capacity, 1));
+        diagnostics->num_entries = diagnostics->num_dropped = 0;
+        diagnostics->capacity = (diagnostics->entries != GS_NULL_PTR) ? capacity : 0;
+        diagnostics->allocator = allocator;
+        if (diagnostics->entries == GS_NULL_PTR) {
+                context->last_error = LexerErrorNoSpace;
+                return false;
+        }
+        return true;
+}
+
+void LexerDiagnosticsDeinit(LexerDiagnostics *diagnostics) {
+        if (diagnostics->entries != GS_NULL_PTR) diagnostics->allocator.free(diagnostics->entries);
+        diagnostics->entries = GS_NULL_PTR;
+        diagnostics->num_entries = diagnostics->capacity = diagnostics->num_dropped = 0;
+}
+
+/* Empties the buffer for another lex, keeping its memory. */
+void LexerDiagnosticsClear(LexerDiagnostics *diagnostics) {
+        diagnostics->num_entries = diagnostics->num_dropped = 0;
+}
+
+const char *LexerDiagnosticString(LexerDiagnosticKind kind) {
+        return __lexer_diagnostic_strings[kind];
+}
+
+void __lexer_DiagnosticsAdd(LexerDiagnostics *diagnostics, char *beginning, Token token, LexerDiagnosticKind kind) {
+        if (diagnostics->num_entries == diagnostics->capacity) {
+                diagnostics->num_dropped++;
+                return;
+        }
+
+        LexerDiagnostic *entry = &diagnostics->entries[diagnostics->num_entries++];
+        entry->offset = (u32)(token.text - beginning);
+        entry->length = token.text_length;
+        entry->kind = (u8)kind;
+}
+
 typedef struct Tokenizer {
         char *beginning;
         char *at;
-        u32 line;
-        u32 column;
+
+        /*
+          Optional pre-lexed token stream.
+          When set, GetToken() returns the token at `cursor' instead of lexing
+          from `at', so restoring a saved Tokenizer is just an index reset.
+        */
+        TokenStream *tokens;
+        u32 cursor;
+
+        LexerSymbols *symbols; /* Optional; identifiers lexed from `at' are interned here. */
+
+        /*
+          Optional; trivia skipped while lexing from `at' is appended here.
+          Only meaningful for a single forward pass, such as LexTokenizer.
+        */
+        LexerTrivia *trivia;
+
+        /*
+          Optional; when set, a byte range that doesn't lex becomes one
+          Token_Unknown error token recorded here, and lexing goes on after it.
+        */
+        LexerDiagnostics *diagnostics;
 } Tokenizer;
 
 void TokenizerInit(Tokenizer *tokenizer, char *memory) {
         tokenizer->beginning = memory;
         tokenizer->at = memory;
-        tokenizer->line = 0;
-        tokenizer->column = 0;
+        tokenizer->tokens = GS_NULL_PTR;
+        tokenizer->cursor = 0;
+        tokenizer->symbols = GS_NULL_PTR;
+        tokenizer->trivia = GS_NULL_PTR;
+        tokenizer->diagnostics = GS_NULL_PTR;
+}
+
+void TokenizerSetSymbols(Tokenizer *tokenizer, LexerSymbols *symbols) {
+        tokenizer->symbols = symbols;
+}
+
+void TokenizerSetTrivia(Tokenizer *tokenizer, LexerTrivia *trivia) {
+        tokenizer->trivia = trivia;
+}
+
+void TokenizerSetDiagnostics(Tokenizer *tokenizer, LexerDiagnostics *diagnostics) {
+        tokenizer->diagnostics = diagnostics;
+}
+
+/*
+  Switches the tokenizer to read from a token stream produced by LexCompact().
+  The stream must end with Token_EndOfStream or Token_Unknown; reading past the
+  end keeps returning that last token.
+*/
+void TokenizerSetStream(Tokenizer *tokenizer, TokenStream *tokens) {
+        tokenizer->tokens = tokens;
+        tokenizer->cursor = 0;
 }
 
+/* Positions are byte offsets only; see LexerLines for lines and columns. */
 void AdvanceTokenizer(Tokenizer *tokenizer) {
-        if (gs_CharIsEndOfLine(tokenizer->at[0])) {
-                ++tokenizer->line;
-                tokenizer->column = 1;
-        } else {
-                ++tokenizer->column;
-        }
         ++tokenizer->at;
 }
 
 void CopyTokenizer(Tokenizer *source, Tokenizer *dest) {
         dest->beginning = source->beginning;
         dest->at = source->at;
-        dest->line = source->line;
-        dest->column = source->column;
 }
 
 void AdvanceTokenizerToChar(Tokenizer *tokenizer, char c) {
@@ -213,18 +770,178 @@ void AdvanceTokenizerToChar(Tokenizer *tokenizer, char c) {
         }
 }
 
+/*
+  Scanning kernels. Each one classifies a whole block of input at a time and
+  returns a bitmask with a bit set for every byte it stops on. Blocks are
+  aligned, so a load never crosses into a page the input doesn't touch; the
+  bytes before the scan start and after the terminating NUL are read but masked
+  off or never reached, which is why these opt out of address sanitizing.
+  Without SSE2 or AVX2 a block is one byte.
+*/
+#if defined(__AVX2__)
+#define LEXER_BLOCK_SIZE 32
+typedef __m256i LexerBlock;
+#define __LexerLoad(At)      _mm256_load_si256((const __m256i *)(At))
+#define __LexerIs(Block, C)  _mm256_cmpeq_epi8((Block), _mm256_set1_epi8(C))
+#define __LexerOr(A, B)      _mm256_or_si256((A), (B))
+#define __LexerMask(Block)   ((u32)_mm256_movemask_epi8(Block))
+#elif defined(__SSE2__)
+#define LEXER_BLOCK_SIZE 16
+typedef __m128i LexerBlock;
+#define __LexerLoad(At)      _mm_load_si128((const __m128i *)(At))
+#define __LexerIs(Block, C)  _mm_cmpeq_epi8((Block), _mm_set1_epi8(C))
+#define __LexerOr(A, B)      _mm_or_si128((A), (B))
+#define __LexerMask(Block)   ((u32)_mm_movemask_epi8(Block))
+#else
+#define LEXER_BLOCK_SIZE 1
+typedef char LexerBlock;
+#define __LexerLoad(At)      (*(At))
+#define __LexerIs(Block, C)  ((Block) == (C))
+#define __LexerOr(A, B)      ((A) || (B))
+#define __LexerMask(Block)   ((u32)(Block))
+#endif
+
+#if defined(__GNUC__)
+#define LEXER_NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define LEXER_NO_SANITIZE
+#endif
+
+#define LEXER_BLOCK_MASK ((u32)(((u64)1 << LEXER_BLOCK_SIZE) - 1))
+
+static inline LEXER_NO_SANITIZE u32 __lexer_NonWhitespace(char *block) {
+        LexerBlock bytes = __LexerLoad(block);
+        LexerBlock space = __LexerOr(__LexerOr(__LexerIs(bytes, ' '), __LexerIs(bytes, '\t')),
+                                     __LexerOr(__LexerIs(bytes, '\n'), __LexerIs(bytes, '\r')));
+        space = __LexerOr(space, __LexerOr(__LexerIs(bytes, '\v'), __LexerIs(bytes, '\f')));
+        return ~__LexerMask(space) & LEXER_BLOCK_MASK;
+}
+
+static inline LEXER_NO_SANITIZE u32 __lexer_SlashOrEnd(char *block) {
+        LexerBlock bytes = __LexerLoad(block);
+        return __LexerMask(__LexerOr(__LexerIs(bytes, '/'), __LexerIs(bytes, '\0')));
+}
+
+static inline LEXER_NO_SANITIZE u32 __lexer_QuoteEscapeOrEnd(char *block) {
+        LexerBlock bytes = __LexerLoad(block);
+        LexerBlock stops = __LexerOr(__LexerIs(bytes, '"'), __LexerIs(bytes, '\\'));
+        return __LexerMask(__LexerOr(stops, __LexerIs(bytes, '\0')));
+}
+
+static inline LEXER_NO_SANITIZE u32 __lexer_NewlineOrEnd(char *block) {
+        LexerBlock bytes = __LexerLoad(block);
+        return __LexerMask(__LexerOr(__LexerIs(bytes, '\n'), __LexerIs(bytes, '\0')));
+}
+
+static inline LEXER_NO_SANITIZE u32 __lexer_LineBreaks(char *block) {
+        LexerBlock bytes = __LexerLoad(block);
+        return __LexerMask(__LexerOr(__LexerIs(bytes, '\n'), __LexerIs(bytes, '\r')));
+}
+
+/* Returns the first byte at or after `at' that `kernel' stops on. */
+static inline char *__lexer_Scan(char *at, u32 (*kernel)(char *)) {
+        u32 offset = (u64)at & (LEXER_BLOCK_SIZE - 1);
+        char *block = at - offset;
+        u32 mask = kernel(block) >> offset << offset;
+
+        while (mask == 0) {
+                block += LEXER_BLOCK_SIZE;
+                mask = kernel(block);
+        }
+
+        return block + __builtin_ctz(mask);
+}
+
+/*
+  Line index over a lexed buffer. The lexer only tracks byte positions; lines
+  and columns are looked up here when something is reported. Every `\n' and
+  `\r' counts as a line break, and lines and columns are numbered from 1.
+*/
+typedef struct LexerLines {
+        char *beginning;
+        u32 *breaks; /* Offset of every line break, in order. */
+        u32 num_breaks;
+        gs_Allocator allocator;
+} LexerLines;
+
+/* Counts the line breaks in [beginning, beginning + length), storing their offsets into `breaks' if non-null. */
+u32 __lexer_FindLineBreaks(char *beginning, u64 length, u32 *breaks) {
+        char *end = beginning + length;
+        u32 offset = (u64)beginning & (LEXER_BLOCK_SIZE - 1);
+        u32 count = 0;
+
+        for (char *block = beginning - offset; block < end; block += LEXER_BLOCK_SIZE) {
+                u32 mask = __lexer_LineBreaks(block);
+                if (block < beginning) mask = mask >> offset << offset;
+                if (end - block < LEXER_BLOCK_SIZE) mask &= ((u32)1 << (end - block)) - 1;
+
+                if (breaks == GS_NULL_PTR) {
+                        count += __builtin_popcount(mask);
+                        continue;
+                }
+                for (; mask != 0; mask &= mask - 1) {
+                        breaks[count++] = (u32)(block + __builtin_ctz(mask) - beginning);
+                }
+        }
+
+        return count;
+}
+
+bool LexerLinesInit(LexerLines *lines, LexerContext *context, char *beginning, u64 length) {
+        gs_Allocator allocator = context->allocator;
+        lines->beginning = beginning;
+        lines->allocator = allocator;
+        lines->breaks = GS_NULL_PTR;
+        lines->num_breaks = __lexer_FindLineBreaks(beginning, length, GS_NULL_PTR);
+        if (lines->num_breaks == 0) return true;
+
+        lines->breaks = (u32 *)allocator.malloc(sizeof(*lines->breaks) * lines->num_breaks);
+        if (lines->breaks == GS_NULL_PTR) {
+                context->last_error = LexerErrorNoLineSpace;
+                lines->num_breaks = 0;
+                return false;
+        }
+
+        __lexer_FindLineBreaks(beginning, length, lines->breaks);
+        return true;
+}
+
+void LexerLinesDeinit(LexerLines *lines) {
+        if (lines->breaks != GS_NULL_PTR) lines->allocator.free(lines->breaks);
+        lines->breaks = GS_NULL_PTR;
+        lines->num_breaks = 0;
+}
+
+/* Finds the line and column of `at', which must point into the indexed buffer. */
+void LexerLinesFind(LexerLines *lines, char *at, u32 *out_line, u32 *out_column) {
+        u32 offset = (u32)(at - lines->beginning);
+
+        u32 low = 0, high = lines->num_breaks;
+        while (low < high) {
+                u32 middle = low + (high - low) / 2;
+                if (lines->breaks[middle] < offset) low = middle + 1;
+                else high = middle;
+        }
+
+        *out_line = low + 1;
+        *out_column = (low == 0) ? offset + 1 : offset - lines->breaks[low - 1];
+}
+
 void CopyToTokenAndAdvance(Tokenizer *tokenizer, Token *token, u32 length, TokenType type) {
         token->text = tokenizer->at;
         token->text_length = length;
         token->type = type;
-        token->line = tokenizer->line;
-        token->column = tokenizer->column;
-
-        for (i32 i =  0; i < length; ++i) AdvanceTokenizer(tokenizer);
+        tokenizer->at += length;
 }
 
+/* Most runs are a space, or a newline and indentation; only longer ones are worth a block scan. */
 void EatAllWhitespace(Tokenizer *tokenizer) {
-        for (; gs_CharIsWhitespace(tokenizer->at[0]); AdvanceTokenizer(tokenizer));
+        for (int i = 0; i < 8; i++) {
+                if (!gs_CharIsWhitespace(tokenizer->at[0])) return;
+                AdvanceTokenizer(tokenizer);
+        }
+
+        tokenizer->at = __lexer_Scan(tokenizer->at, __lexer_NonWhitespace);
 }
 
 bool IsIdentifierCharacter(char c) {
@@ -243,10 +960,12 @@ bool GetCharacter(Tokenizer *tokenizer, Token *token) {
         ++cursor; /* Skip past the first single quote. */
 
         /* Read until closing single quote. */
-        for (; *cursor != '\''; ++cursor);
+        for (; *cursor != '\''; ++cursor) {
+                if (*cursor == '\0') return false;
+        }
 
         /* If previous character is an escape, then closing quote is next char. */
-        if (*(cursor-1) == '\\' && *(cursor -2) != '\\') {
+        if (*(cursor-1) == '\\' && *(cursor -2) != '\\' && cursor[1] != '\0') {
                 ++cursor;
         }
         ++cursor; /* Point to character after literal. */
@@ -259,15 +978,25 @@ bool GetCharacter(Tokenizer *tokenizer, Token *token) {
         return true;
 }
 
+/*
+  Skips to the closing quote of a string from `cursor' in its body, stepping
+  over escaped characters. Short of one, stops at the terminating NUL or at a
+  backslash just before it, which is where scanning picks up again once more
+  input follows.
+*/
+char *__lexer_StringClose(char *cursor) {
+        for (; ; cursor += 2) {
+                cursor = __lexer_Scan(cursor, __lexer_QuoteEscapeOrEnd);
+                if (*cursor != '\\' || cursor[1] == '\0') return cursor;
+        }
+}
+
 bool GetString(Tokenizer *tokenizer, Token *token) {
         char *cursor = tokenizer->at;
         if (*cursor != '"') return false;
 
-        while (true) {
-                ++cursor;
-                if (*cursor == '\0') return false;
-                if (*cursor == '"' && *(cursor - 1) != '\\') break;
-        }
+        cursor = __lexer_StringClose(cursor + 1);
+        if (*cursor != '"') return false;
         ++cursor; /* Swallow the last double quote. */
 
         CopyToTokenAndAdvance(tokenizer, token, cursor - tokenizer->at, Token_String);
@@ -378,23 +1107,58 @@ bool GetPrecisionNumber(Tokenizer *tokenizer, Token *token) {
         return false;
 }
 
+/*
+  Returns how many trailing characters of the integer spelling `text' are its
+  suffix, and the type the suffix gives. A suffix is u, l or ll, or u together
+  with either in any order, in any case; ll can't mix cases.
+*/
+u32 __lexer_IntegerSuffix(char *text, u32 length, LexerValueType *out_type) {
+        u32 i = length;
+        bool is_unsigned = false;
+        u32 num_longs = 0;
+
+        if (i > 0 && (text[i - 1] == 'u' || text[i - 1] == 'U')) {
+                is_unsigned = true;
+                i--;
+        }
+        if (i > 1 && ((text[i - 1] == 'l' && text[i - 2] == 'l') || (text[i - 1] == 'L' && text[i - 2] == 'L'))) {
+                num_longs = 2;
+                i -= 2;
+        } else if (i > 0 && (text[i - 1] == 'l' || text[i - 1] == 'L')) {
+                num_longs = 1;
+                i--;
+        }
+        if (!is_unsigned && num_longs > 0 && i > 0 && (text[i - 1] == 'u' || text[i - 1] == 'U')) {
+                is_unsigned = true;
+                i--;
+        }
+
+        static const LexerValueType types[2][3] = {
+                { LexerValue_Int, LexerValue_Long, LexerValue_LongLong },
+                { LexerValue_UnsignedInt, LexerValue_UnsignedLong, LexerValue_UnsignedLongLong },
+        };
+        *out_type = types[is_unsigned][num_longs];
+
+        return length - i;
+}
+
 bool GetInteger(Tokenizer *tokenizer, Token *token) {
         char *last_char = tokenizer->at;
         for (; *last_char && (gs_CharIsDecimal(*last_char) || gs_CharIsAlphabetical(*last_char)); ++last_char);
 
         int length = last_char - tokenizer->at;
-        --last_char;
-
-        /* Token->Type = Token_Unknown; */
-        /* Token->Text = Tokenizer->At; */
-        /* Token->Textlength = length; */
 
         if (length < 1) return false;
 
         char *cursor = tokenizer->at;
 
-        if ((IsOctalString(cursor, length) || IsHexadecimalString(cursor, length)) ||
-            (1 == length && '0' == *cursor)) {
+        /* The digits are checked without their suffix. */
+        LexerValueType type;
+        int num_digits = length - __lexer_IntegerSuffix(cursor, length, &type);
+        if (num_digits < 1) return false;
+
+        if ((IsOctalString(cursor, num_digits) || IsHexadecimalString(cursor, num_digits)) ||
+            (1 == num_digits && '0' == *cursor)) {
                 CopyToTokenAndAdvance(tokenizer, token, length, Token_Integer);
                 return true;
         }
@@ -404,211 +1168,919 @@ bool GetInteger(Tokenizer *tokenizer, Token *token) {
                 return false;
         }
 
-        for (int i=0; i<length-1; ++i) {
+        for (int i = 0; i < num_digits; ++i) {
                 if (!gs_CharIsDecimal(cursor[i])) {
                         return false;
                 }
         }
 
-        if (gs_CharIsDecimal(*last_char) || IsIntegerSuffix(*last_char)) {
-                CopyToTokenAndAdvance(tokenizer, token, length, Token_Integer);
-                return true;
-        }
+        CopyToTokenAndAdvance(tokenizer, token, length, Token_Integer);
+        return true;
+}
 
-        return false;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define LEXER_SWAR_DIGITS 1
+#else
+#define LEXER_SWAR_DIGITS 0
+#endif
+
+/*
+  Eight decimal digits at once: each step multiplies neighbouring lanes
+  together, so two, then four, then all eight digits combine in three
+  multiplies.
+*/
+static inline u32 __lexer_EightDigits(char *text) {
+        u64 chunk;
+        memcpy(&chunk, text, sizeof(chunk));
+        chunk -= 0x3030303030303030ull;
+        chunk = (chunk * 10) + (chunk >> 8);
+        chunk = (((chunk & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+                 (((chunk >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+        return (u32)chunk;
 }
 
-bool GetIdentifier(Tokenizer *tokenizer, Token *token) {
-        if (!gs_CharIsAlphabetical(tokenizer->at[0]) &&
-           '_' != tokenizer->at[0]) {
-                return false;
-        }
+/*
+  Accumulates `length' digits in `radix' into `value'; false if it overflows 64
+  bits, with `value' holding the low 64 bits. Only a number with at least as
+  many significant digits as the largest 64-bit value can overflow, so only the
+  digits from the twentieth on pay for overflow checks.
+*/
+bool __lexer_DecodeDigits(char *text, u32 length, u32 radix, u64 *value) {
+        for (; length > 1 && *text == '0'; text++, length--);
+        u64 result = 0;
+        u32 i = 0;
+
+        if (radix == 10) {
+                u32 unchecked = gs_Min(length, 19);
+#if LEXER_SWAR_DIGITS
+                for (; i + 8 <= unchecked; i += 8) {
+                        result = result * 100000000 + __lexer_EightDigits(text + i);
+                }
+#endif
+                for (; i < unchecked; i++) {
+                        result = result * 10 + (text[i] - '0');
+                }
 
-        char *cursor = tokenizer->at;
+                /* The checks leave the wrapped result behind, so the low bits are kept past an overflow. */
+                bool fits = true;
+                for (; i < length; i++) {
+                        fits &= !__builtin_mul_overflow(result, (u64)10, &result);
+                        fits &= !__builtin_add_overflow(result, (u64)(text[i] - '0'), &result);
+                }
+                *value = result;
+                return fits;
+        }
 
-        for (; IsIdentifierCharacter(*cursor); ++cursor);
-        CopyToTokenAndAdvance(tokenizer, token, cursor - tokenizer->at, Token_Identifier);
+        /* Hex digits are branch-free: letters have bit 6 set and their low nibble counts from 1. */
+        u32 shift = (radix == 16) ? 4 : 3;
+        for (; i < length; i++) {
+                u8 c = (u8)text[i];
+                result = (result << shift) | ((c & 0xF) + 9 * (c >> 6));
+        }
+        *value = result;
 
-        return true;
+        u32 first = (text[0] & 0xF) + 9 * ((u8)text[0] >> 6);
+        u32 bits = (length - 1) * shift + (32 - __builtin_clz(first | 1));
+        return bits <= 64;
 }
 
-bool GetComment(Tokenizer *tokenizer, Token *token) {
-        if (tokenizer->at[0] != '/' || tokenizer->at[1] != '*') return false;
-
-        char *cursor = tokenizer->at;
+/* Powers of ten that a double holds exactly. */
+static const f64 __lexer_powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
 
-        while (true) {
-                if ('\0' == *cursor) {
-                        return false;
+/*
+  With at most 19 significant digits, a mantissa below 2^53 and a power of ten
+  up to 22, both operands are exact and one multiply or divide rounds
+  correctly. Anything else goes to strtod, which stops at the end of the
+  token: a floating constant is never followed by something strtod would
+  read on into.
+*/
+void __lexer_DecodeFloating(char *text, u32 length, LexerValue *value) {
+        char last = text[length - 1];
+        value->type = (last == 'f' || last == 'F') ? LexerValue_Float :
+                      (last == 'l' || last == 'L') ? LexerValue_LongDouble : LexerValue_Double;
+        value->radix = 10;
+        value->overflow = false;
+
+        u64 mantissa = 0;
+        u32 num_significant = 0;
+        bool truncated = false;
+        i32 exponent = 0;
+
+        char *c = text;
+        for (bool fraction = false; ; c++) {
+                if (*c == '.' && !fraction) {
+                        fraction = true;
+                        continue;
                 }
+                if (!gs_CharIsDecimal(*c)) break;
+
+                if (num_significant < 19) {
+                        mantissa = mantissa * 10 + (*c - '0');
+                        if (mantissa != 0) num_significant++;
+                        if (fraction) exponent--;
+                } else {
+                        truncated = true;
+                        if (!fraction) exponent++;
+                }
+        }
 
-                if ('*' == cursor[0] && '/' == cursor[1]) {
-                        break;
+        if (*c == 'e' || *c == 'E') {
+                c++;
+                bool negative = (*c == '-');
+                if (negative) c++;
+
+                i32 written = 0;
+                for (; gs_CharIsDecimal(*c); c++) {
+                        if (written < 100000) written = written * 10 + (*c - '0');
                 }
-                ++cursor;
+                exponent += negative ? -written : written;
         }
 
-        cursor += 2; /* Swallow last two characters: asterisk, slash */
+        if (!truncated && mantissa <= ((u64)1 << 53) && exponent >= -22 && exponent <= 22) {
+                f64 result = (f64)mantissa;
+                value->as.floating = (exponent < 0) ? result / __lexer_powers_of_ten[-exponent] :
+                                                      result * __lexer_powers_of_ten[exponent];
+        } else {
+                value->as.floating = strtod(text, GS_NULL_PTR);
+        }
+}
 
-        CopyToTokenAndAdvance(tokenizer, token, cursor - tokenizer->at, Token_Comment);
+/* A character constant's value is its characters' bytes, first byte highest. */
+bool __lexer_DecodeCharacter(char *text, u32 length, LexerValue *value) {
+        char *c = text + 1;
+        char *end = text + length - 1; /* The closing quote. */
+        if (c >= end) return false;
+
+        u64 result = 0;
+        while (c < end) {
+                u8 byte = (u8)*c++;
+                if (byte == '\\' && c < end) {
+                        byte = (u8)*c++;
+                        switch (byte) {
+                                case 'a': byte = '\a'; break;
+                                case 'b': byte = '\b'; break;
+                                case 'f': byte = '\f'; break;
+                                case 'n': byte = '\n'; break;
+                                case 'r': byte = '\r'; break;
+                                case 't': byte = '\t'; break;
+                                case 'v': byte = '\v'; break;
+                                default: {
+                                        if (gs_CharIsOctal(byte)) {
+                                                byte -= '0';
+                                                for (u32 i = 1; i < 3 && c < end && gs_CharIsOctal(*c); i++) {
+                                                        byte = (byte << 3) | (*c++ - '0');
+                                                }
+                                        }
+                                } break; /* \\, \', \" and \? stand for themselves. */
+                        }
+                }
+                result = (result << 8) | byte;
+        }
 
+        value->as.integer = result;
+        value->type = LexerValue_Character;
+        value->radix = 10;
+        value->overflow = false;
         return true;
 }
 
-bool GetKeyword(Tokenizer *tokenizer, Token *token) {
-        static char *keywords[] = {
-                "auto", "break", "case", "char", "const", "continue", "default",
-                "double", "do", "else", "enum", "extern", "float", "for",
-                "goto", "if", "int", "long", "register", "return", "short",
-                "signed", "sizeof", "static", "struct", "switch", "typedef",
-                "union", "unsigned", "void", "volatile", "while"
+/*
+  Gives a decoded integer constant the first type from `type', the one its
+  suffix names, that holds its value, widening as C99 6.4.4.1 does: int, long,
+  long long, and for octal and hexadecimal constants the unsigned type after
+  each. Types are sized as on LP64 targets, which the AST's values assume. If
+  none holds it, it is flagged as overflowing and has the widest it may have.
+*/
+void __lexer_IntegerType(LexerValue *value, LexerValueType type) {
+        /* In the order of LexerValueType, signed and unsigned alternating. */
+        static const u64 maxima[] = {
+                0x7FFFFFFFull, 0xFFFFFFFFull,
+                0x7FFFFFFFFFFFFFFFull, 0xFFFFFFFFFFFFFFFFull,
+                0x7FFFFFFFFFFFFFFFull, 0xFFFFFFFFFFFFFFFFull,
         };
 
-        for (int i = 0; i < gs_ArraySize(keywords); ++i) {
-                if (gs_StringIsEqual(tokenizer->at, keywords[i], gs_StringLength(keywords[i]))) {
-                        CopyToTokenAndAdvance(tokenizer, token, gs_StringLength(keywords[i]), Token_Keyword);
+        bool is_unsigned = (type - LexerValue_Int) % 2 == 1;
+        for (u32 candidate = type; candidate <= LexerValue_UnsignedLongLong; candidate++) {
+                bool candidate_unsigned = (candidate - LexerValue_Int) % 2 == 1;
+                if (candidate_unsigned != is_unsigned && (is_unsigned || value->radix == 10)) continue;
 
-                        return true;
-                }
+                value->type = (u8)candidate;
+                if (!value->overflow && value->as.integer <= maxima[candidate - LexerValue_Int]) return;
         }
 
-        return false;
+        value->overflow = true;
 }
 
-bool GetPreprocessorCommand(Tokenizer *tokenizer, Token *token) {
-        if (tokenizer->at[0] != '#') return false;
-
-        char *cursor = tokenizer->at;
+/* Decodes an integer, floating or character constant; false for any other token. */
+bool LexerDecodeConstant(Token token, LexerValue *out_value) {
+        char *text = token.text;
+
+        switch (token.type) {
+                case Token_Integer: {
+                        LexerValueType type;
+                        u32 num_digits = token.text_length - __lexer_IntegerSuffix(text, token.text_length, &type);
+
+                        if (num_digits > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+                                out_value->radix = 16;
+                                text += 2;
+                                num_digits -= 2;
+                        } else if (num_digits > 1 && text[0] == '0') {
+                                out_value->radix = 8;
+                                text += 1;
+                                num_digits -= 1;
+                        } else {
+                                out_value->radix = 10;
+                        }
+
+                        out_value->overflow = !__lexer_DecodeDigits(text, num_digits, out_value->radix, &out_value->as.integer);
+                        __lexer_IntegerType(out_value, type);
+                        return true;
+                }
 
-        /* Preprocessor commands must start a line on their own. */
-        for (--cursor; cursor > tokenizer->beginning && gs_CharIsWhitespace(*cursor); --cursor);
+                case Token_PrecisionNumber: {
+                        __lexer_DecodeFloating(text, token.text_length, out_value);
+                        return true;
+                }
 
-        if (*(++cursor) != '\n' && cursor != tokenizer->beginning) {
-                return false;
-        }
-        cursor = tokenizer->at + 1; /* Skip the starting '#' for macros. */
+                case Token_Character: {
+                        return __lexer_DecodeCharacter(text, token.text_length, out_value);
+                }
 
-        while (true) {
-                if (*cursor == '\n' && *(cursor - 1) != '\\') break;
-                if (*cursor == '\0') break;
-                ++cursor;
+                default: {
+                        return false;
+                }
         }
+}
 
-        CopyToTokenAndAdvance(tokenizer, token, cursor - tokenizer->at, Token_PreprocessorCommand);
+bool TokenIsKeyword(TokenType type) {
+        return type >= Token_KeywordAuto && type <= Token_KeywordWhile;
+}
 
-        return true;
+bool TokenIsConstant(TokenType type) {
+        return type == Token_Integer || type == Token_PrecisionNumber || type == Token_Character;
 }
 
-bool GetSymbol(Tokenizer *tokenizer, Token *token, char *symbol, TokenType type) {
-        int length = gs_StringLength(symbol);
-        if (!gs_StringIsEqual(tokenizer->at, symbol, length)) return false;
+/*
+  Perfect hash over the 32 keywords: no two keywords share a slot, so a word is
+  a keyword exactly when it equals the one entry in its slot. The multipliers
+  were found by searching for the smallest collision-free pair.
+*/
+typedef struct LexerKeyword {
+        char *text;
+        TokenType type;
+} LexerKeyword;
+
+static const LexerKeyword __lexer_keywords[64] = {
+        [0] = { "return", Token_KeywordReturn },
+        [1] = { "const", Token_KeywordConst },
+        [3] = { "volatile", Token_KeywordVolatile },
+        [4] = { "signed", Token_KeywordSigned },
+        [7] = { "float", Token_KeywordFloat },
+        [8] = { "char", Token_KeywordChar },
+        [9] = { "long", Token_KeywordLong },
+        [10] = { "if", Token_KeywordIf },
+        [11] = { "auto", Token_KeywordAuto },
+        [12] = { "while", Token_KeywordWhile },
+        [16] = { "switch", Token_KeywordSwitch },
+        [17] = { "case", Token_KeywordCase },
+        [20] = { "break", Token_KeywordBreak },
+        [21] = { "else", Token_KeywordElse },
+        [23] = { "goto", Token_KeywordGoto },
+        [29] = { "continue", Token_KeywordContinue },
+        [33] = { "short", Token_KeywordShort },
+        [36] = { "void", Token_KeywordVoid },
+        [38] = { "extern", Token_KeywordExtern },
+        [39] = { "int", Token_KeywordInt },
+        [41] = { "default", Token_KeywordDefault },
+        [42] = { "sizeof", Token_KeywordSizeof },
+        [43] = { "do", Token_KeywordDo },
+        [45] = { "enum", Token_KeywordEnum },
+        [46] = { "unsigned", Token_KeywordUnsigned },
+        [49] = { "static", Token_KeywordStatic },
+        [50] = { "register", Token_KeywordRegister },
+        [51] = { "union", Token_KeywordUnion },
+        [52] = { "struct", Token_KeywordStruct },
+        [57] = { "double", Token_KeywordDouble },
+        [59] = { "for", Token_KeywordFor },
+        [63] = { "typedef", Token_KeywordTypedef },
+};
+
+#define __LEXER_KEYWORD_HASH(Text, Length) \
+        ((2 * (u8)(Text)[0] + 19 * ((u8)(Text)[(Length) - 1] + (Length))) & 63)
+
+TokenType __lexer_WordType(char *text, u32 length) {
+        if (length < 2 || length > 8) return Token_Identifier;
+
+        const LexerKeyword *keyword = &__lexer_keywords[__LEXER_KEYWORD_HASH(text, length)];
+        if (keyword->text == GS_NULL_PTR) return Token_Identifier;
+
+        for (u32 i = 0; i < length; i++) {
+                if (keyword->text[i] != text[i]) return Token_Identifier;
+        }
+
+        return (keyword->text[length] == '\0') ? keyword->type : Token_Identifier;
+}
+
+/* Classifies the identifier or keyword of `length' bytes the DFA scanned. */
+void __lexer_FinishWord(Tokenizer *tokenizer, Token *token, u32 length) {
+        CopyToTokenAndAdvance(tokenizer, token, length, __lexer_WordType(tokenizer->at, length));
+
+        if (token->type == Token_Identifier && tokenizer->symbols != GS_NULL_PTR) {
+                token->symbol = LexerSymbolsIntern(tokenizer->symbols, token->text, length);
+        }
+}
+
+/*
+  Skips to the closing slash of the comment starting at `start', from `cursor'
+  in its body, or to the terminating NUL.
+*/
+char *__lexer_CommentClose(char *start, char *cursor) {
+        /* The closing slash must follow an asterisk that isn't the opening one. */
+        while (true) {
+                cursor = __lexer_Scan(cursor, __lexer_SlashOrEnd);
+                if ('\0' == *cursor) return cursor;
+                if ('*' == cursor[-1] && cursor - 1 >= start + 2) return cursor;
+                ++cursor;
+        }
+}
+
+bool GetComment(Tokenizer *tokenizer, Token *token) {
+        if (tokenizer->at[0] != '/' || tokenizer->at[1] != '*') return false;
 
-        CopyToTokenAndAdvance(tokenizer, token, length, type);
+        char *cursor = __lexer_CommentClose(tokenizer->at, tokenizer->at + 2);
+        if ('\0' == *cursor) return false;
+        ++cursor; /* Swallow the closing slash. */
+
+        CopyToTokenAndAdvance(tokenizer, token, cursor - tokenizer->at, Token_Comment);
 
         return true;
 }
 
-Token GetToken(Tokenizer *tokenizer) {
-        EatAllWhitespace(tokenizer);
+/* Whether the `#' at the tokenizer starts a line on its own, as preprocessor commands must. */
+bool __lexer_StartsDirective(Tokenizer *tokenizer) {
+        char *cursor = tokenizer->at;
+        for (--cursor; cursor > tokenizer->beginning && gs_CharIsWhitespace(*cursor); --cursor);
 
-        Token token;
-        token.text = tokenizer->at;
-        token.text_length = 0;
-        token.type = Token_Unknown;
-
-        {
-                GetSymbol(tokenizer, &token, "==", Token_LogicalEqual) ||
-                        GetSymbol(tokenizer, &token, "<<=", Token_DoubleLessThanEquals) ||
-                        GetSymbol(tokenizer, &token, ">>=", Token_DoubleGreaterThanEquals) ||
-                        GetSymbol(tokenizer, &token, "...", Token_Ellipsis) ||
-                        GetSymbol(tokenizer, &token, "!=", Token_NotEqual) ||
-                        GetSymbol(tokenizer, &token, ">=", Token_GreaterThanEqual) ||
-                        GetSymbol(tokenizer, &token, "<=", Token_LessThanEqual) ||
-                        GetSymbol(tokenizer, &token, "->", Token_Arrow) ||
-                        GetSymbol(tokenizer, &token, "||", Token_LogicalOr) ||
-                        GetSymbol(tokenizer, &token, "&&", Token_LogicalAnd) ||
-                        GetSymbol(tokenizer, &token, "<<", Token_BitShiftLeft) ||
-                        GetSymbol(tokenizer, &token, ">>", Token_BitShiftRight) ||
-                        GetSymbol(tokenizer, &token, "++", Token_PlusPlus) ||
-                        GetSymbol(tokenizer, &token, "--", Token_MinusMinus) ||
-
-                        GetSymbol(tokenizer, &token, "*=", Token_MultiplyEquals) ||
-                        GetSymbol(tokenizer, &token, "/=", Token_DivideEquals) ||
-                        GetSymbol(tokenizer, &token, "%=", Token_ModuloEquals) ||
-                        GetSymbol(tokenizer, &token, "+=", Token_PlusEquals) ||
-                        GetSymbol(tokenizer, &token, "-=", Token_MinusEquals) ||
-                        GetSymbol(tokenizer, &token, "&=", Token_AmpersandEquals) ||
-                        GetSymbol(tokenizer, &token, "^=", Token_CaratEquals) ||
-                        GetSymbol(tokenizer, &token, "|=", Token_PipeEquals);
+        return *(++cursor) == '\n' || cursor == tokenizer->beginning;
+}
 
+/* Skips from `cursor' in a directive to the line break that isn't escaped, or to the terminating NUL. */
+char *__lexer_DirectiveEnd(char *cursor) {
+        while (true) {
+                cursor = __lexer_Scan(cursor, __lexer_NewlineOrEnd);
+                if (*cursor == '\0' || *(cursor - 1) != '\\') return cursor;
+                ++cursor;
         }
+}
 
-        if (token.type != Token_Unknown) return token;
+bool GetPreprocessorCommand(Tokenizer *tokenizer, Token *token) {
+        if (tokenizer->at[0] != '#') return false;
+        if (!__lexer_StartsDirective(tokenizer)) return false;
+
+        /* Skip the starting '#' for macros. */
+        char *cursor = __lexer_DirectiveEnd(tokenizer->at + 1);
+
+        CopyToTokenAndAdvance(tokenizer, token, cursor - tokenizer->at, Token_PreprocessorCommand);
+
+        return true;
+}
 
-        {
-                GetKeyword(tokenizer, &token) ||
-                        GetCharacter(tokenizer, &token) ||
-                        GetPreprocessorCommand(tokenizer, &token) ||
-                        GetComment(tokenizer, &token) ||
-                        GetString(tokenizer, &token) ||
-                        GetPrecisionNumber(tokenizer, &token) ||
-                        GetInteger(tokenizer, &token) ||
-                        GetIdentifier(tokenizer, &token);
+Token __TokenizerNextStreamToken(Tokenizer *tokenizer) {
+        Token token = TokenStreamGet(tokenizer->tokens, tokenizer->cursor);
+        if (tokenizer->cursor + 1 < tokenizer->tokens->num_tokens) {
+                ++tokenizer->cursor;
         }
 
-        if (token.type == Token_PreprocessorCommand || token.type == Token_Comment) {
-                token = GetToken(tokenizer);
+        /* Keep the text position in sync for callers reporting errors. */
+        tokenizer->at = token.text + token.text_length;
+
+        return token;
+}
+
+/*
+  GetToken runs the DFA that tools/lexer_dfa.c compiles from the token grammar
+  (`make dfa'), one table lookup per byte, to the longest match. Punctuators
+  and operators end there; tokens with bodies end in a state whose action
+  hands the token to its scanner, falling back to the state's one-byte token.
+  Adding a token kind is a grammar change rather than another probe here.
+*/
+typedef enum LexerAction {
+        LexerAction_None, /* Not an accepting state. */
+        LexerAction_Token,
+        LexerAction_Word,
+        LexerAction_Number,
+        LexerAction_Fraction,
+        LexerAction_Character,
+        LexerAction_String,
+        LexerAction_Directive,
+        LexerAction_Comment,
+} LexerAction;
+
+#include "lexer_dfa.h"
+
+/* Skips to the line break or terminating NUL at or after `cursor'. */
+char *__lexer_LineEnd(char *cursor) {
+        for (; *cursor != '\n' && *cursor != '\0'; ++cursor);
+        return cursor;
+}
+
+/*
+  Widens the one-byte unknown token GetToken just took into the whole bad
+  range, so lexing resumes at a plausible token boundary, and records it.
+*/
+void __lexer_RecoverError(Tokenizer *tokenizer, Token *token) {
+        char *start = token->text;
+        char *end = tokenizer->at;
+        LexerDiagnosticKind kind;
+
+        if (*start == '"') {
+                kind = LexerDiagnostic_UnterminatedString;
+                end = __lexer_LineEnd(end);
+        } else if (*start == '\'') {
+                kind = LexerDiagnostic_BadCharacter;
+                for (; *end != '\'' && *end != '\n' && *end != '\0'; ++end);
+                if (*end == '\'') ++end;
+        } else if (gs_CharIsDecimal(*start)) {
+                kind = LexerDiagnostic_BadNumber;
+                for (; IsIdentifierCharacter(*end) || *end == '.'; ++end);
+        } else {
+                kind = LexerDiagnostic_StrayCharacter;
+                while (*end != '\0' && !gs_CharIsWhitespace(*end) &&
+                       __lexer_dfa_next[LEXER_DFA_START][__lexer_dfa_classes[(u8)*end]] == LEXER_DFA_DEAD) {
+                        ++end;
+                }
+        }
+
+        token->text_length = end - start;
+        tokenizer->at = end;
+        __lexer_DiagnosticsAdd(tokenizer->diagnostics, tokenizer->beginning, *token, kind);
+}
+
+/*
+  Kept whole: split into an inlined stream check and an out-of-line lexer, the
+  token is returned through two frames, which costs a third of lexing speed.
+*/
+__attribute__((noinline)) Token GetToken(Tokenizer *tokenizer) {
+        if (tokenizer->tokens != GS_NULL_PTR) {
+                return __TokenizerNextStreamToken(tokenizer);
+        }
+
+        LexerTrivia *trivia = tokenizer->trivia;
+        u32 first_trivia = (trivia != GS_NULL_PTR) ? trivia->num_trivia : 0;
+        Token token;
+        u8 accepted;
+
+        /* Comments and directives are skipped in a loop, however many there are in a row. */
+        do {
+                EatAllWhitespace(tokenizer);
+
+                token.text = tokenizer->at;
+                token.text_length = 0;
+                token.type = Token_Unknown;
+                token.symbol = LEXER_NO_SYMBOL;
+
+                /* The terminating NUL ends every path, so this never reads past it. */
+                char *cursor = tokenizer->at;
+                char *end = cursor;
+                u8 state = LEXER_DFA_START;
+                accepted = LEXER_DFA_DEAD;
+                do {
+                        state = __lexer_dfa_next[state][__lexer_dfa_classes[(u8)*cursor++]];
+                        bool accepting = (__lexer_dfa_action[state] != LexerAction_None);
+                        accepted = accepting ? state : accepted;
+                        end = accepting ? cursor : end;
+                } while (state != LEXER_DFA_DEAD && state < LEXER_DFA_FIRST_FINAL);
+
+                switch (__lexer_dfa_action[accepted]) {
+                        case LexerAction_Token: {
+                                CopyToTokenAndAdvance(tokenizer, &token, end - tokenizer->at, __lexer_dfa_token[accepted]);
+                        } break;
+
+                        case LexerAction_Word: {
+                                __lexer_FinishWord(tokenizer, &token, end - tokenizer->at);
+                        } break;
+
+                        case LexerAction_Number: {
+                                if (!GetPrecisionNumber(tokenizer, &token)) GetInteger(tokenizer, &token);
+                        } break;
+
+                        case LexerAction_Fraction: {
+                                GetPrecisionNumber(tokenizer, &token);
+                        } break;
+
+                        case LexerAction_Character: {
+                                GetCharacter(tokenizer, &token);
+                        } break;
+
+                        case LexerAction_String: {
+                                GetString(tokenizer, &token);
+                        } break;
+
+                        case LexerAction_Directive: {
+                                if (GetPreprocessorCommand(tokenizer, &token) && trivia != GS_NULL_PTR) {
+                                        __lexer_TriviaAdd(trivia, tokenizer->beginning, token);
+                                }
+                        } break;
+
+                        case LexerAction_Comment: {
+                                if (GetComment(tokenizer, &token) && trivia != GS_NULL_PTR) {
+                                        __lexer_TriviaAdd(trivia, tokenizer->beginning, token);
+                                }
+                        } break;
+                }
+        } while (token.type == Token_PreprocessorCommand || token.type == Token_Comment);
+
+        if (trivia != GS_NULL_PTR && trivia->num_trivia != first_trivia) {
+                __lexer_TriviaAttach(trivia, first_trivia, (u32)(token.text - tokenizer->beginning));
         }
 
         if (token.type != Token_Unknown) return token;
 
-        char c = tokenizer->at[0];
-        CopyToTokenAndAdvance(tokenizer, &token, 1, Token_Unknown);
-
-        switch (c) {
-                case '\0':{ token.type = Token_EndOfStream; } break;
-                case '(': { token.type = Token_OpenParen; } break;
-                case ')': { token.type = Token_CloseParen; } break;
-                case ':': { token.type = Token_Colon; } break;
-                case ';': { token.type = Token_SemiColon; } break;
-                case '*': { token.type = Token_Asterisk; } break;
-                case '[': { token.type = Token_OpenBracket; } break;
-                case ']': { token.type = Token_CloseBracket; } break;
-                case '{': { token.type = Token_OpenBrace; } break;
-                case '}': { token.type = Token_CloseBrace; } break;
-                case ',': { token.type = Token_Comma; } break;
-                case '-': { token.type = Token_Dash; } break;
-                case '+': { token.type = Token_Cross; } break;
-                case '=': { token.type = Token_EqualSign; } break;
-                case '^': { token.type = Token_Carat; } break;
-                case '&': { token.type = Token_Ampersand; } break;
-                case '%': { token.type = Token_PercentSign; } break;
-                case '?': { token.type = Token_QuestionMark; } break;
-                case '!': { token.type = Token_Bang; } break;
-                case '/': { token.type = Token_Slash; } break;
-                case '|': { token.type = Token_Pipe; } break;
-                case '<': { token.type = Token_LessThan; } break;
-                case '>': { token.type = Token_GreaterThan; } break;
-                case '~': { token.type = Token_Tilde; } break;
-                case '.': { token.type = Token_Dot; } break;
-                case '#': { token.type = Token_Hash; } break;
+        /* Nothing matched, or the scanner didn't take it: the state's one-byte token. */
+        CopyToTokenAndAdvance(tokenizer, &token, 1, __lexer_dfa_token[accepted]);
+        if (token.type == Token_Unknown && tokenizer->diagnostics != GS_NULL_PTR) {
+                __lexer_RecoverError(tokenizer, &token);
         }
 
         return token;
 }
 
-bool Lex(gs_Allocator allocator, gs_Buffer *input_stream, Token **out_stream, u32 *out_num_tokens) {
+/* Returns the next token without advancing the tokenizer. */
+Token PeekToken(Tokenizer *tokenizer) {
+        Tokenizer lookahead = *tokenizer;
+        lookahead.trivia = GS_NULL_PTR; /* The trivia is recorded when the token is taken. */
+
+        /* So are errors; the copy still widens them the same way. */
+        LexerDiagnostics *diagnostics = tokenizer->diagnostics;
+        u32 num_entries = (diagnostics != GS_NULL_PTR) ? diagnostics->num_entries : 0;
+        u32 num_dropped = (diagnostics != GS_NULL_PTR) ? diagnostics->num_dropped : 0;
+
+        Token token = GetToken(&lookahead);
+
+        if (diagnostics != GS_NULL_PTR) {
+                diagnostics->num_entries = num_entries;
+                diagnostics->num_dropped = num_dropped;
+        }
+        return token;
+}
+
+/* Starting capacity of a token buffer when the caller has no size hint. */
+#define LEXER_DEFAULT_CAPACITY 1024
+
+/*
+  Estimates how many tokens `length' bytes at `text' lex into, without lexing:
+  one block scan counts the runs of non-whitespace, and a run averages a bit
+  over one and a half tokens in C (`f(x);' is one run, five tokens). Good as a
+  size hint for LexTokenizer; never a bound.
+*/
+u32 LexerEstimateTokens(char *text, u64 length) {
+        char *end = text + length;
+        u32 offset = (u64)text & (LEXER_BLOCK_SIZE - 1);
+        u32 carry = 0;
+        u64 runs = 0;
+
+        for (char *block = text - offset; block < end; block += LEXER_BLOCK_SIZE) {
+                u32 mask = __lexer_NonWhitespace(block);
+                if (block < text) mask = mask >> offset << offset;
+                if (end - block < LEXER_BLOCK_SIZE) mask &= ((u32)1 << (end - block)) - 1;
+
+                runs += __builtin_popcount(mask & ~((mask << 1) | carry) & LEXER_BLOCK_MASK);
+                carry = mask >> (LEXER_BLOCK_SIZE - 1);
+        }
+
+        u64 estimate = runs + runs / 2 + runs / 8 + 1;
+        return (estimate > 0xFFFFFFFF) ? 0xFFFFFFFF : (u32)estimate;
+}
+
+/*
+  Lexes from the tokenizer's current position into a buffer that starts at
+  `size_hint' tokens (LEXER_DEFAULT_CAPACITY if 0) and doubles whenever it
+  fills. Stops after Token_EndOfStream, after Token_Unknown unless the
+  tokenizer records diagnostics, or, when `end' is non-null, before the first
+  token that starts at or after `end', leaving the tokenizer at that token.
+  Touches no global state, so several of these can run at once over the same
+  buffer.
+*/
+bool __lexer_LexUntil(gs_Allocator allocator, Tokenizer *tokenizer, char *end, u32 size_hint, Token **out_stream, u32 *out_num_tokens) {
+        u32 capacity = (size_hint > 0) ? size_hint : LEXER_DEFAULT_CAPACITY;
+        Token *token_stream = (Token *)allocator.malloc(sizeof(*token_stream) * (u64)capacity);
+        *out_num_tokens = 0;
+        if (token_stream == GS_NULL_PTR) return false;
+
+        u32 num_tokens = 0;
+
+        bool lexing = true;
+        while (lexing) {
+                if (num_tokens == capacity) {
+                        capacity *= 2;
+                        Token *grown = (Token *)allocator.realloc(token_stream, sizeof(*token_stream) * (u64)capacity);
+                        if (grown == GS_NULL_PTR) {
+                                allocator.free(token_stream);
+                                return false;
+                        }
+                        token_stream = grown;
+                }
+
+                Token token = GetToken(tokenizer);
+                if (end != GS_NULL_PTR && token.text >= end) {
+                        tokenizer->at = token.text;
+                        break;
+                }
+
+                token_stream[num_tokens++] = token;
+                lexing = (token.type != Token_EndOfStream &&
+                          (token.type != Token_Unknown || tokenizer->diagnostics != GS_NULL_PTR));
+        }
+
+        *out_stream = token_stream;
+        *out_num_tokens = num_tokens;
+        return true;
+}
+
+/*
+  Lexes everything from the tokenizer's current position.
+  The token buffer grows from `size_hint' as __lexer_LexUntil describes and is
+  trimmed to fit at the end.
+*/
+bool LexTokenizer(LexerContext *context, Tokenizer *tokenizer, u32 size_hint, Token **out_stream, u32 *out_num_tokens) {
+        gs_Allocator allocator = context->allocator;
+        Token *token_stream;
+        u32 num_tokens;
+        bool lexed = __lexer_LexUntil(allocator, tokenizer, GS_NULL_PTR, size_hint, &token_stream, &num_tokens);
+        if (lexed && tokenizer->trivia != GS_NULL_PTR && tokenizer->trivia->out_of_memory) {
+                allocator.free(token_stream);
+                lexed = false;
+        }
+        if (!lexed) {
+                context->last_error = LexerErrorNoSpace;
+                *out_num_tokens = 0;
+                return false;
+        }
+
+        if (token_stream[num_tokens - 1].type == Token_Unknown) {
+                context->last_error = LexerUnknownToken;
+        }
+
+        // Trim the stream now.
+        *out_stream = (Token *)allocator.realloc(token_stream, sizeof(*token_stream) * num_tokens);
+        if (*out_stream == GS_NULL_PTR) {
+                allocator.free(token_stream);
+                context->last_error = LexerReallocFail;
+                *out_num_tokens = 0;
+                return false;
+        }
+
+        *out_num_tokens = num_tokens;
+        return true;
+}
+
+bool Lex(LexerContext *context, gs_Buffer *input_stream, Token **out_stream, u32 *out_num_tokens) {
         Tokenizer tokenizer;
         TokenizerInit(&tokenizer, input_stream->start);
 
-        // Overestimate allocation.
-        // This assumes one token per char; which is way too much.
-        // We'll resize later.
-        Token *token_stream = *out_stream;
-        token_stream = (Token *)allocator.malloc(sizeof(*token_stream) * input_stream->length);
-        if (token_stream == GS_NULL_PTR) {
-                __lexer_last_error = LexerErrorNoSpace;
-                out_num_tokens = 0;
+        u32 size_hint = LexerEstimateTokens(input_stream->start, input_stream->length);
+        return LexTokenizer(context, &tokenizer, size_hint, out_stream, out_num_tokens);
+}
+
+/*
+  Like Lex, but lexes to the end of input however many errors there are: each
+  bad byte range is one Token_Unknown in the stream and one entry in
+  `diagnostics', which must be initialized and is not cleared first.
+*/
+bool LexWithDiagnostics(LexerContext *context, gs_Buffer *input_stream, LexerDiagnostics *diagnostics, Token **out_stream, u32 *out_num_tokens) {
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, input_stream->start);
+        TokenizerSetDiagnostics(&tokenizer, diagnostics);
+
+        u32 size_hint = LexerEstimateTokens(input_stream->start, input_stream->length);
+        return LexTokenizer(context, &tokenizer, size_hint, out_stream, out_num_tokens);
+}
+
+/* Parallel lexing never splits the input into chunks smaller than this. */
+#define LEXER_PARALLEL_MIN_CHUNK (64 * 1024)
+#define LEXER_PARALLEL_MAX_THREADS 256
+
+/*
+  One chunk of a parallel lex: the tokens that start in [start, end), lexed as
+  if `start' were outside any comment, string or directive. `resume' is where
+  the next chunk's tokens must begin, or null if lexing stopped at the end of
+  input or on an unknown token.
+*/
+typedef struct LexerChunk {
+        char *beginning; /* Of the whole input. */
+        char *start;
+        char *end;
+        gs_Allocator allocator;
+
+        Token *tokens;
+        u32 num_tokens;
+        u32 first; /* Tokens before this one were lexed from a wrong guess. */
+        char *resume;
+        bool ok;
+} LexerChunk;
+
+void *__lexer_LexChunk(void *data) {
+        LexerChunk *chunk = (LexerChunk *)data;
+
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, chunk->beginning);
+        tokenizer.at = chunk->start;
+
+        u32 size_hint = LexerEstimateTokens(chunk->start, chunk->end - chunk->start);
+        chunk->first = 0;
+        chunk->ok = __lexer_LexUntil(chunk->allocator, &tokenizer, chunk->end, size_hint, &chunk->tokens, &chunk->num_tokens);
+
+        chunk->resume = tokenizer.at;
+        if (chunk->ok && chunk->num_tokens > 0) {
+                TokenType last = chunk->tokens[chunk->num_tokens - 1].type;
+                if (last == Token_EndOfStream || last == Token_Unknown) chunk->resume = GS_NULL_PTR;
+        }
+
+        return GS_NULL_PTR;
+}
+
+/* Finds the chunk token starting at `text'; chunk tokens are ordered by position. */
+bool __lexer_ChunkFind(LexerChunk *chunk, char *text, u32 *out_index) {
+        u32 low = 0, high = chunk->num_tokens;
+        while (low < high) {
+                u32 middle = low + (high - low) / 2;
+                if (chunk->tokens[middle].text < text) low = middle + 1;
+                else high = middle;
+        }
+
+        *out_index = low;
+        return low < chunk->num_tokens && chunk->tokens[low].text == text;
+}
+
+/*
+  Like Lex, but splits the input at line starts into up to `num_threads' chunks
+  (0 means one per online processor) and lexes them at once, each assuming it
+  starts outside any comment, string or directive. Chunks are then checked in
+  order: lexing is deterministic from any token start, so a chunk whose tokens
+  include the position the previous chunk stopped at is correct from that
+  token on. A chunk that guessed wrong is lexed again from the right position.
+  `allocator' must be safe to call from several threads.
+*/
+bool LexParallel(LexerContext *context, gs_Buffer *input_stream, u32 num_threads, Token **out_stream, u32 *out_num_tokens) {
+        gs_Allocator allocator = context->allocator;
+        *out_num_tokens = 0;
+
+        if (num_threads == 0) num_threads = (u32)sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = gs_Min(num_threads, LEXER_PARALLEL_MAX_THREADS);
+        u32 num_chunks = gs_Min(num_threads, input_stream->length / LEXER_PARALLEL_MIN_CHUNK);
+        if (num_chunks <= 1) return Lex(context, input_stream, out_stream, out_num_tokens);
+
+        LexerChunk chunks[LEXER_PARALLEL_MAX_THREADS];
+        pthread_t threads[LEXER_PARALLEL_MAX_THREADS];
+
+        char *beginning = input_stream->start;
+        char *input_end = beginning + input_stream->length;
+        u64 chunk_length = input_stream->length / num_chunks;
+
+        char *start = beginning;
+        for (u32 i = 0; i < num_chunks; i++) {
+                char *end = input_end + 1; /* Takes in the Token_EndOfStream at the NUL. */
+                if (i + 1 < num_chunks) {
+                        end = gs_Max(start, beginning + chunk_length * (i + 1));
+                        while (end < input_end && end[-1] != '\n') end++;
+                }
+
+                chunks[i] = (LexerChunk){ .beginning = beginning, .start = start, .end = end, .allocator = allocator };
+                start = gs_Min(end, input_end);
+        }
+
+        /* The first chunk starts at the beginning, so it is always lexed right; do it on this thread. */
+        bool started[LEXER_PARALLEL_MAX_THREADS] = { false };
+        for (u32 i = 1; i < num_chunks; i++) {
+                started[i] = (pthread_create(&threads[i], GS_NULL_PTR, __lexer_LexChunk, &chunks[i]) == 0);
+        }
+        __lexer_LexChunk(&chunks[0]);
+        for (u32 i = 1; i < num_chunks; i++) {
+                if (started[i]) pthread_join(threads[i], GS_NULL_PTR);
+                else __lexer_LexChunk(&chunks[i]);
+        }
+
+        bool ok = true;
+        for (u32 i = 0; i < num_chunks; i++) ok = ok && chunks[i].ok;
+
+        /* Validate each chunk against where the one before it really stopped. */
+        u64 num_tokens = chunks[0].num_tokens;
+        char *resume = chunks[0].resume;
+        for (u32 i = 1; ok && i < num_chunks; i++) {
+                LexerChunk *chunk = &chunks[i];
+
+                if (resume == GS_NULL_PTR || resume >= chunk->end) {
+                        chunk->first = chunk->num_tokens; /* Nothing of this chunk is reached. */
+                        continue;
+                }
+
+                if (!__lexer_ChunkFind(chunk, resume, &chunk->first)) {
+                        allocator.free(chunk->tokens);
+                        chunk->start = resume;
+                        __lexer_LexChunk(chunk);
+                        ok = chunk->ok;
+                }
+
+                num_tokens += chunk->num_tokens - chunk->first;
+                resume = chunk->resume;
+        }
+
+        Token *token_stream = GS_NULL_PTR;
+        if (ok) {
+                token_stream = (Token *)allocator.malloc(sizeof(*token_stream) * num_tokens);
+                ok = (token_stream != GS_NULL_PTR);
+        }
+
+        u64 at = 0;
+        for (u32 i = 0; i < num_chunks; i++) {
+                if (!chunks[i].ok) continue;
+                if (ok) {
+                        u32 count = chunks[i].num_tokens - chunks[i].first;
+                        gs_MemCopy(chunks[i].tokens + chunks[i].first, token_stream + at, sizeof(*token_stream) * count);
+                        at += count;
+                }
+                allocator.free(chunks[i].tokens);
+        }
+
+        if (!ok) {
+                context->last_error = LexerErrorNoSpace;
+                return false;
+        }
+
+        if (token_stream[num_tokens - 1].type == Token_Unknown) {
+                context->last_error = LexerUnknownToken;
+        }
+
+        *out_stream = token_stream;
+        *out_num_tokens = num_tokens;
+        return true;
+}
+
+/* Resizes every array of `stream' to `capacity' tokens. On failure the stream is left as it was. */
+bool __lexer_TokenStreamResize(TokenStream *stream, u32 capacity) {
+        gs_Allocator allocator = stream->allocator;
+
+        u8 *kind = (u8 *)allocator.realloc(stream->kind, sizeof(*kind) * (u64)capacity);
+        if (kind == GS_NULL_PTR) return false;
+        stream->kind = kind;
+
+        u32 *offset = (u32 *)allocator.realloc(stream->offset, sizeof(*offset) * (u64)capacity);
+        if (offset == GS_NULL_PTR) return false;
+        stream->offset = offset;
+
+        u32 *length = (u32 *)allocator.realloc(stream->length, sizeof(*length) * (u64)capacity);
+        if (length == GS_NULL_PTR) return false;
+        stream->length = length;
+
+        u32 *payload = (u32 *)allocator.realloc(stream->payload, sizeof(*payload) * (u64)capacity);
+        if (payload == GS_NULL_PTR) return false;
+        stream->payload = payload;
+
+        return true;
+}
+
+/* Grows the side table to hold at least `capacity' values. */
+bool __lexer_TokenStreamReserveValues(TokenStream *stream, u32 capacity) {
+        if (capacity <= stream->values_capacity) return true;
+        capacity = gs_Max(capacity, gs_Max(stream->values_capacity * 2, 64));
+        gs_Allocator allocator = stream->allocator;
+
+        u32 *value_token = (u32 *)allocator.realloc(stream->value_token, sizeof(*value_token) * (u64)capacity);
+        if (value_token == GS_NULL_PTR) return false;
+        stream->value_token = value_token;
+
+        LexerValue *value = (LexerValue *)allocator.realloc(stream->value, sizeof(*value) * (u64)capacity);
+        if (value == GS_NULL_PTR) return false;
+        stream->value = value;
+
+        stream->values_capacity = capacity;
+        return true;
+}
+
+/*
+  Like LexTokenizer, but into a compact stream. Offsets are relative to the
+  tokenizer's beginning. Identifiers carry symbols if the tokenizer interns
+  them, and constants are decoded into the side table as they are lexed.
+*/
+bool LexTokenizerCompact(LexerContext *context, Tokenizer *tokenizer, u32 size_hint, TokenStream *out_stream) {
+        gs_Allocator allocator = context->allocator;
+        u32 capacity = (size_hint > 0) ? size_hint : LEXER_DEFAULT_CAPACITY;
+        out_stream->source = tokenizer->beginning;
+        out_stream->allocator = allocator;
+        out_stream->num_tokens = 0;
+        out_stream->kind = GS_NULL_PTR;
+        out_stream->offset = out_stream->length = out_stream->payload = GS_NULL_PTR;
+        out_stream->symbols = tokenizer->symbols;
+        out_stream->recovering = (tokenizer->diagnostics != GS_NULL_PTR);
+        out_stream->value_token = GS_NULL_PTR;
+        out_stream->value = GS_NULL_PTR;
+        out_stream->num_values = out_stream->values_capacity = 0;
+        if (!__lexer_TokenStreamResize(out_stream, capacity)) {
+                TokenStreamDeinit(out_stream);
+                context->last_error = LexerErrorNoSpace;
                 return false;
         }
 
@@ -616,30 +2088,553 @@ bool Lex(gs_Allocator allocator, gs_Buffer *input_stream, Token **out_stream, u3
 
         bool lexing = true;
         while (lexing) {
-                Token token = GetToken(&tokenizer);
-                token_stream[num_tokens++] = token;
+                if (num_tokens == capacity) {
+                        capacity *= 2;
+                        if (!__lexer_TokenStreamResize(out_stream, capacity)) {
+                                TokenStreamDeinit(out_stream);
+                                context->last_error = LexerErrorNoSpace;
+                                return false;
+                        }
+                }
+
+                Token token = GetToken(tokenizer);
+                out_stream->kind[num_tokens] = (u8)token.type;
+                out_stream->offset[num_tokens] = (u32)(token.text - tokenizer->beginning);
+                out_stream->length[num_tokens] = token.text_length;
+                out_stream->payload[num_tokens] = token.symbol;
+
+                if (TokenIsConstant(token.type)) {
+                        u32 entry = out_stream->num_values;
+                        if (!__lexer_TokenStreamReserveValues(out_stream, entry + 1)) {
+                                TokenStreamDeinit(out_stream);
+                                context->last_error = LexerErrorNoSpace;
+                                return false;
+                        }
+                        if (LexerDecodeConstant(token, &out_stream->value[entry])) {
+                                out_stream->value_token[entry] = num_tokens;
+                                out_stream->payload[num_tokens] = entry;
+                                out_stream->num_values++;
+                        }
+                }
+
+                num_tokens++;
+
                 switch (token.type) {
                         case Token_EndOfStream: {
                                 lexing = false;
                         } break;
 
                         case Token_Unknown: {
-                                __lexer_last_error = LexerUnknownToken;
+                                if (tokenizer->diagnostics != GS_NULL_PTR) break;
+                                context->last_error = LexerUnknownToken;
                                 lexing = false;
                         } break;
                 }
         }
 
-        // Resize the stream now.
-        *out_stream = (Token *)allocator.realloc(token_stream, sizeof(*token_stream) * num_tokens);
-        if (*out_stream == GS_NULL_PTR) {
-                __lexer_last_error = LexerReallocFail;
-                out_num_tokens = 0;
+        if (tokenizer->trivia != GS_NULL_PTR && tokenizer->trivia->out_of_memory) {
+                TokenStreamDeinit(out_stream);
+                context->last_error = LexerErrorNoSpace;
                 return false;
         }
 
-        *out_num_tokens = num_tokens;
+        if (!__lexer_TokenStreamResize(out_stream, num_tokens)) {
+                TokenStreamDeinit(out_stream);
+                context->last_error = LexerReallocFail;
+                return false;
+        }
+
+        out_stream->num_tokens = num_tokens;
         return true;
 }
 
+bool LexCompact(LexerContext *context, gs_Buffer *input_stream, TokenStream *out_stream) {
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, input_stream->start);
+
+        u32 size_hint = LexerEstimateTokens(input_stream->start, input_stream->length);
+        return LexTokenizerCompact(context, &tokenizer, size_hint, out_stream);
+}
+
+/*
+  Open comments, strings and character literals scan to the end of the input
+  and come back as a slash before `*' or an unknown token at the quote.
+*/
+bool __lexer_TokenIsOpen(Token token) {
+        if (token.type == Token_Slash) return token.text[1] == '*';
+        return token.type == Token_Unknown && (token.text[0] == '"' || token.text[0] == '\'');
+}
+
+/*
+  Incremental re-lexing: updates `stream' after `removed_length' bytes of its
+  source at `edit_offset' were replaced by `inserted_length' new ones.
+  `edited_source' is the whole NUL-terminated source after the edit; the stream
+  refers to it from then on.
+
+  Lexing restarts after the last token whose lexing can't have looked at the
+  edit: one followed by whitespace before the edit, since no token looks past
+  the whitespace after it. It stops at the first new token past the inserted
+  text that starts where an old token did, shifted by the edit. Lexing is
+  deterministic from a token start and the text from there on is unchanged, so
+  the old tokens from there are reused with their offsets shifted.
+
+  A stream lexed with recovery is re-lexed with recovery too, so error tokens
+  are widened as before and lexing goes on past them. Diagnostics for the
+  re-lexed text aren't recorded anywhere; its error tokens stand for them.
+
+  Returns false if memory runs out, leaving the stream on the old source; lex
+  the edited source from scratch then.
+*/
+bool LexEdit(TokenStream *stream, char *edited_source, u32 edit_offset, u32 removed_length, u32 inserted_length) {
+        gs_Allocator allocator = stream->allocator;
+        i64 delta = (i64)inserted_length - (i64)removed_length;
+        u32 num_tokens = stream->num_tokens;
+
+        /* Tokens before `first' are untouched by the edit. */
+        u32 low = 0, high = num_tokens;
+        while (low < high) {
+                u32 middle = low + (high - low) / 2;
+                if (stream->offset[middle] < edit_offset) low = middle + 1;
+                else high = middle;
+        }
+        u32 first = low;
+
+        /*
+          An open comment, string or character scanned to the end of the input,
+          so the edit can close it. Without recovery, unknown tokens only ever
+          end the stream; slashes, and unknown tokens in a recovering stream,
+          are found with a byte search over the token types.
+        */
+        u8 *slash = stream->kind;
+        while ((slash = memchr(slash, Token_Slash, stream->kind + first - slash)) != GS_NULL_PTR) {
+                u32 i = slash - stream->kind;
+                if (edited_source[stream->offset[i] + 1] == '*') {
+                        first = i;
+                        break;
+                }
+                slash++;
+        }
+        if (stream->recovering) {
+                u8 *unknown = stream->kind;
+                while ((unknown = memchr(unknown, Token_Unknown, stream->kind + first - unknown)) != GS_NULL_PTR) {
+                        u32 i = unknown - stream->kind;
+                        char quote = edited_source[stream->offset[i]];
+                        if (quote == '"' || quote == '\'') {
+                                first = i;
+                                break;
+                        }
+                        unknown++;
+                }
+        } else if (first == num_tokens && stream->kind[first - 1] == Token_Unknown) {
+                Token last = TokenStreamGet(stream, first - 1);
+                last.text = edited_source + stream->offset[first - 1];
+                if (__lexer_TokenIsOpen(last)) first--;
+        }
+
+        for (; first > 0; first--) {
+                u32 end = stream->offset[first - 1] + stream->length[first - 1];
+                char *c = edited_source + end;
+                while (c < edited_source + edit_offset && !gs_CharIsWhitespace(*c)) c++;
+                if (c < edited_source + edit_offset) break;
+        }
+
+        /* Lexing stopped on an unknown token before the edit; nothing after it is lexed. */
+        if (first == num_tokens) {
+                stream->source = edited_source;
+                return true;
+        }
+
+        /* Errors are only counted; the caller's diagnostics refer to the old source. */
+        LexerDiagnostics diagnostics = { GS_NULL_PTR, 0, 0, 0, allocator };
+
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, edited_source);
+        TokenizerSetSymbols(&tokenizer, stream->symbols);
+        if (stream->recovering) TokenizerSetDiagnostics(&tokenizer, &diagnostics);
+        if (first > 0) tokenizer.at = edited_source + stream->offset[first - 1] + stream->length[first - 1];
+
+        u32 capacity = LEXER_DEFAULT_CAPACITY;
+        Token *relexed = (Token *)allocator.malloc(sizeof(*relexed) * capacity);
+        if (relexed == GS_NULL_PTR) return false;
+        u32 num_relexed = 0;
+
+        /* Old tokens from `resume' on are reused. */
+        u32 resume = first;
+        u64 unchanged = (u64)edit_offset + inserted_length;
+        while (true) {
+                Token token = GetToken(&tokenizer);
+                u64 offset = token.text - edited_source;
+
+                if (offset >= unchanged) {
+                        i64 old_offset = (i64)offset - delta;
+                        while (resume < num_tokens && stream->offset[resume] < old_offset) resume++;
+                        if (resume < num_tokens && stream->offset[resume] == old_offset) break;
+                }
+
+                if (num_relexed == capacity) {
+                        capacity *= 2;
+                        Token *grown = (Token *)allocator.realloc(relexed, sizeof(*relexed) * capacity);
+                        if (grown == GS_NULL_PTR) {
+                                allocator.free(relexed);
+                                return false;
+                        }
+                        relexed = grown;
+                }
+                relexed[num_relexed++] = token;
+
+                if (token.type == Token_EndOfStream || (token.type == Token_Unknown && !stream->recovering)) {
+                        resume = num_tokens;
+                        break;
+                }
+        }
+
+        /* Splice: untouched head, relexed tokens, then the shifted old tail. */
+        u32 num_reused = num_tokens - resume;
+        u32 new_num_tokens = first + num_relexed + num_reused;
+        if (new_num_tokens > num_tokens && !__lexer_TokenStreamResize(stream, new_num_tokens)) {
+                allocator.free(relexed);
+                return false;
+        }
+
+        /* Room for the side table too, so nothing changes unless everything can. */
+        u32 head = __lexer_TokenStreamValueAt(stream, first);
+        u32 tail = __lexer_TokenStreamValueAt(stream, resume);
+        u32 num_tail_values = stream->num_values - tail;
+        u32 max_new_values = 0;
+        for (u32 i = 0; i < num_relexed; i++) {
+                if (TokenIsConstant(relexed[i].type)) max_new_values++;
+        }
+        if (!__lexer_TokenStreamReserveValues(stream, head + max_new_values + num_tail_values)) {
+                allocator.free(relexed);
+                return false;
+        }
+
+        u32 to = first + num_relexed;
+        if (to == resume) {
+                for (u32 i = 0; i < num_reused; i++) stream->offset[to + i] += (u32)delta;
+        } else if (to > resume) {
+                for (u32 i = num_reused; i-- > 0;) {
+                        stream->kind[to + i] = stream->kind[resume + i];
+                        stream->offset[to + i] = (u32)(stream->offset[resume + i] + delta);
+                        stream->length[to + i] = stream->length[resume + i];
+                        stream->payload[to + i] = stream->payload[resume + i];
+                }
+        } else {
+                for (u32 i = 0; i < num_reused; i++) {
+                        stream->kind[to + i] = stream->kind[resume + i];
+                        stream->offset[to + i] = (u32)(stream->offset[resume + i] + delta);
+                        stream->length[to + i] = stream->length[resume + i];
+                        stream->payload[to + i] = stream->payload[resume + i];
+                }
+        }
+
+        for (u32 i = 0; i < num_relexed; i++) {
+                stream->kind[first + i] = (u8)relexed[i].type;
+                stream->offset[first + i] = (u32)(relexed[i].text - edited_source);
+                stream->length[first + i] = relexed[i].text_length;
+                stream->payload[first + i] = relexed[i].symbol;
+        }
+
+        /*
+          The side table is spliced the same way, and moved constants point at
+          their new entries. A stream without constants has no side table to
+          move within.
+        */
+        if (num_tail_values > 0) {
+                memmove(stream->value_token + head + max_new_values, stream->value_token + tail, sizeof(*stream->value_token) * num_tail_values);
+                memmove(stream->value + head + max_new_values, stream->value + tail, sizeof(*stream->value) * num_tail_values);
+        }
+        u32 num_values = head;
+        for (u32 i = 0; i < num_relexed; i++) {
+                if (TokenIsConstant(relexed[i].type) && LexerDecodeConstant(relexed[i], &stream->value[num_values])) {
+                        stream->value_token[num_values] = first + i;
+                        stream->payload[first + i] = num_values++;
+                }
+        }
+        if (num_tail_values > 0 && num_values < head + max_new_values) {
+                memmove(stream->value_token + num_values, stream->value_token + head + max_new_values, sizeof(*stream->value_token) * num_tail_values);
+                memmove(stream->value + num_values, stream->value + head + max_new_values, sizeof(*stream->value) * num_tail_values);
+        }
+        if (num_values != tail || to != resume) {
+                for (u32 entry = num_values; entry < num_values + num_tail_values; entry++) {
+                        stream->value_token[entry] += to - resume;
+                        stream->payload[stream->value_token[entry]] = entry;
+                }
+        }
+        stream->num_values = num_values + num_tail_values;
+        allocator.free(relexed);
+
+        if (new_num_tokens < num_tokens) __lexer_TokenStreamResize(stream, new_num_tokens);
+        stream->num_tokens = new_num_tokens;
+        stream->source = edited_source;
+        return true;
+}
+
+/*
+  Streaming lexer: input arrives in pieces through LexerStreamFeed, and
+  LexerStreamNext hands out tokens once no later input can change them.
+
+  A token is final once every byte GetToken read to lex it has arrived, that
+  is once lexing it didn't run into the end of the input so far. Comments,
+  directives and strings can run on for any length, so one still open at the
+  end of the input is scanned on from where the last call stopped rather than
+  from its start; comments and directives are skipped here, as GetToken
+  would, and a string is lexed again once it closes.
+
+  The buffer keeps the last byte before the tokenizer that isn't whitespace,
+  which directives look back at, and everything after it; it is compacted on
+  each feed. Tokens point into the buffer and are only valid until the next
+  LexerStreamFeed.
+*/
+typedef struct LexerStream {
+        LexerContext *context;
+        char *buffer; /* NUL-terminated. */
+        u64 length;
+        u64 capacity;
+        u64 base; /* Offset in the whole input of buffer[0]. */
+        u64 anchor; /* Index in the buffer of the last byte before the tokenizer that isn't whitespace. */
+        u64 open; /* Index in the buffer where scanning the open comment, directive or string at the tokenizer resumes, or 0. */
+        bool finished;
+        Tokenizer tokenizer;
+
+        /* Where LexerStreamPosition last left off. */
+        u64 position_offset;
+        u32 position_line;
+        u32 position_column;
+} LexerStream;
+
+bool LexerStreamInit(LexerStream *stream, LexerContext *context) {
+        stream->context = context;
+        stream->capacity = LEXER_DEFAULT_CAPACITY;
+        stream->buffer = (char *)context->allocator.malloc(stream->capacity);
+        if (stream->buffer == GS_NULL_PTR) {
+                context->last_error = LexerErrorNoSpace;
+                return false;
+        }
+        stream->buffer[0] = '\0';
+        stream->length = 0;
+        stream->base = 0;
+        stream->anchor = 0;
+        stream->open = 0;
+        stream->finished = false;
+        TokenizerInit(&stream->tokenizer, stream->buffer);
+
+        stream->position_offset = 0;
+        stream->position_line = 1;
+        stream->position_column = 1;
+        return true;
+}
+
+void LexerStreamDeinit(LexerStream *stream) {
+        stream->context->allocator.free(stream->buffer);
+        stream->buffer = GS_NULL_PTR;
+        stream->length = stream->capacity = 0;
+}
+
+/* Moves the position tracker forward to `to', which must not be before it. */
+void __lexer_StreamTrack(LexerStream *stream, char *to) {
+        for (char *at = stream->buffer + (stream->position_offset - stream->base); at < to; at++) {
+                if (gs_CharIsEndOfLine(*at)) {
+                        ++stream->position_line;
+                        stream->position_column = 1;
+                } else {
+                        ++stream->position_column;
+                }
+        }
+        stream->position_offset = stream->base + (to - stream->buffer);
+}
+
+/* Appends input. Returns false if the buffer can't grow; the stream is then unchanged. */
+bool LexerStreamFeed(LexerStream *stream, char *data, u64 length) {
+        /* Drop everything before the anchor. */
+        char *keep = stream->buffer + stream->anchor;
+        if (stream->position_offset < stream->base + stream->anchor) __lexer_StreamTrack(stream, keep);
+
+        u64 dropped = stream->anchor;
+        u64 at = stream->tokenizer.at - keep;
+        u64 kept = stream->length - dropped;
+        if (dropped > 0) gs_MemCopy(keep, stream->buffer, kept);
+        stream->base += dropped;
+        stream->length = kept;
+        stream->buffer[kept] = '\0';
+        stream->tokenizer.beginning = stream->buffer;
+        stream->tokenizer.at = stream->buffer + at;
+        stream->anchor = 0;
+        if (stream->open != 0) stream->open -= dropped;
+
+        u64 needed = kept + length + 1;
+        if (needed > stream->capacity) {
+                u64 capacity = gs_Max(stream->capacity * 2, needed);
+                char *grown = (char *)stream->context->allocator.realloc(stream->buffer, capacity);
+                if (grown == GS_NULL_PTR) {
+                        stream->context->last_error = LexerErrorNoSpace;
+                        return false;
+                }
+                stream->buffer = grown;
+                stream->capacity = capacity;
+                stream->tokenizer.beginning = grown;
+                stream->tokenizer.at = grown + at;
+        }
+
+        gs_MemCopy(data, stream->buffer + stream->length, length);
+        stream->length += length;
+        stream->buffer[stream->length] = '\0';
+
+        return true;
+}
+
+/* Marks the end of input; every remaining token is then final. */
+void LexerStreamFinish(LexerStream *stream) {
+        stream->finished = true;
+}
+
+/* Moves the tokenizer on to `to', keeping the anchor on the last byte before it that isn't whitespace. */
+void __lexer_StreamAdvance(LexerStream *stream, char *to) {
+        char *last = to;
+        while (last > stream->tokenizer.at && gs_CharIsWhitespace(last[-1])) last--;
+        if (last > stream->tokenizer.at) stream->anchor = (last - 1) - stream->buffer;
+        stream->tokenizer.at = to;
+}
+
+/*
+  Skips the comments and directives at the tokenizer, and scans on through an
+  open string there. Returns false while one of them runs to the end of the
+  input so far.
+*/
+bool __lexer_StreamSkip(LexerStream *stream) {
+        Tokenizer *tokenizer = &stream->tokenizer;
+
+        while (true) {
+                char *cursor;
+                if (stream->open != 0) {
+                        cursor = stream->buffer + stream->open;
+                } else {
+                        EatAllWhitespace(tokenizer);
+                        if (tokenizer->at[0] == '/' && tokenizer->at[1] == '*') cursor = tokenizer->at + 2;
+                        else if (tokenizer->at[0] == '#' && __lexer_StartsDirective(tokenizer)) cursor = tokenizer->at + 1;
+                        else return true;
+                }
+
+                char *start = tokenizer->at;
+                if (start[0] == '"') {
+                        cursor = __lexer_StringClose(cursor);
+                        if (*cursor == '"') break;
+                } else if (start[0] == '#') {
+                        cursor = __lexer_DirectiveEnd(cursor);
+                        if (*cursor != '\0') {
+                                stream->open = 0;
+                                __lexer_StreamAdvance(stream, cursor);
+                                continue;
+                        }
+                } else {
+                        cursor = __lexer_CommentClose(start, cursor);
+                        if (*cursor != '\0') {
+                                stream->open = 0;
+                                __lexer_StreamAdvance(stream, cursor + 1);
+                                continue;
+                        }
+                }
+
+                /* At the end GetToken lexes what is left open, as it would in the whole input. */
+                if (stream->finished) break;
+                stream->open = cursor - stream->buffer;
+                return false;
+        }
+
+        stream->open = 0;
+        return true;
+}
+
+/*
+  One past the last byte GetToken read to lex `token', which mustn't be an
+  open one. The DFA reads one byte past the longest match it tries, the number
+  scanners one past the number and past the letters and digits it starts, and
+  GetCharacter one past the literal.
+*/
+char *__lexer_TokenHorizon(Token token) {
+        char *text = token.text;
+        if (text[0] == '\'') return text + token.text_length + 1;
+
+        char *cursor = text;
+        u8 state = LEXER_DFA_START;
+        do {
+                state = __lexer_dfa_next[state][__lexer_dfa_classes[(u8)*cursor++]];
+        } while (state != LEXER_DFA_DEAD && state < LEXER_DFA_FIRST_FINAL);
+
+        if (state == LEXER_DFA_DEAD) return cursor;
+        if (__lexer_dfa_action[state] != LexerAction_Number && __lexer_dfa_action[state] != LexerAction_Fraction) {
+                return cursor;
+        }
+
+        /* As far as GetPrecisionNumber reads... */
+        cursor = text;
+        for (; gs_CharIsDecimal(*cursor); ++cursor);
+        if ('.' == *cursor) {
+                for (++cursor; gs_CharIsDecimal(*cursor); ++cursor);
+        }
+        if ('e' == *cursor || 'E' == *cursor) {
+                if ('-' == *(++cursor)) ++cursor;
+                for (; gs_CharIsDecimal(*cursor); ++cursor);
+        }
+
+        /* ...or GetInteger. */
+        char *word = text;
+        for (; gs_CharIsDecimal(*word) || gs_CharIsAlphabetical(*word); ++word);
+
+        return gs_Max(cursor, word) + 1;
+}
+
+bool __lexer_StreamTokenIsFinal(LexerStream *stream, Token token) {
+        if (stream->finished) return true;
+        if (token.type == Token_EndOfStream) return false;
+
+        char *end = stream->buffer + stream->length;
+        if (__lexer_TokenIsOpen(token)) {
+                /* Too long to be a character literal whatever comes next. */
+                return token.text[0] == '\'' && end - token.text > 4;
+        }
+
+        return token.text + token.text_length <= end && __lexer_TokenHorizon(token) <= end;
+}
+
+/*
+  Gets the next token if it is final. Returns false when more input is needed.
+  After LexerStreamFinish this always succeeds, ending with
+  Token_EndOfStream.
+*/
+bool LexerStreamNext(LexerStream *stream, Token *out_token) {
+        if (!__lexer_StreamSkip(stream)) return false;
+
+        Tokenizer lookahead = stream->tokenizer;
+        Token token = GetToken(&lookahead);
+        if (!__lexer_StreamTokenIsFinal(stream, token)) {
+                /* Only the token itself needs lexing again. */
+                stream->tokenizer.at = token.text;
+                if (token.type == Token_Unknown && token.text[0] == '"') {
+                        stream->open = __lexer_StringClose(token.text + 1) - stream->buffer;
+                }
+                return false;
+        }
+
+        __lexer_StreamAdvance(stream, lookahead.at);
+        *out_token = token;
+        return true;
+}
+
+/* Offset of `token' in the whole input. */
+u64 LexerStreamTokenOffset(LexerStream *stream, Token token) {
+        return stream->base + (token.text - stream->buffer);
+}
+
+/*
+  Line and column of `token', numbered from 1 as LexerLinesFind does. Counted
+  on from the last token asked about, so ask in order and before the next
+  feed.
+*/
+void LexerStreamPosition(LexerStream *stream, Token token, u32 *out_line, u32 *out_column) {
+        __lexer_StreamTrack(stream, token.text);
+        *out_line = stream->position_line;
+        *out_column = stream->position_column;
+}
+
 #endif /* LEXER_C */
@@ -22,11 +22,79 @@
 void Usage(const char *name) {
         printf("Usage: %s operation file [options]\n", name);
         puts("  operation: One of: [parse, lex].");
-        puts("  file: Must be a file in this directory.");
+        puts("  file: Must be a file in this directory, or '-' to lex standard input as it arrives.");
+        puts("  options:");
+        puts("    --memoize: Memoize parse rules; uses more memory but bounds backtracking.");
+        puts("    --flat: Parse into the flat, index-based tree layout.");
+        puts("    --compact: Drop placeholder and empty nodes and collapse single-child chains.");
+        puts("    --threads N: Lex on N threads; 0 means one per processor.");
+        puts("    --recover: Lex past errors, reporting each on standard error.");
         puts("  Specify '-h' or '--help' for this help text.");
         exit(EXIT_SUCCESS);
 }
 
+void PrintToken(Token token, u32 line, u32 column) {
+        printf("[%u,%u] Token Name: %20s, Token Text: %.*s\n",
+               line,
+               column,
+               TokenName(token.type),
+               (u32)(token.text_length),
+               token.text);
+}
+
+/* Lexes standard input with the streaming lexer, printing tokens as they complete. */
+int LexStandardInput(LexerContext *context) {
+        LexerStream stream;
+        if (!LexerStreamInit(&stream, context)) {
+                fprintf(stderr, "%s\n", LexerErrorString(context));
+                return EXIT_FAILURE;
+        }
+
+        char chunk[64 * 1024];
+        bool lexing = true;
+        while (lexing) {
+                size_t bytes_read = fread(chunk, 1, sizeof(chunk), stdin);
+                if (bytes_read == 0) {
+                        LexerStreamFinish(&stream);
+                } else if (!LexerStreamFeed(&stream, chunk, bytes_read)) {
+                        fprintf(stderr, "%s\n", LexerErrorString(context));
+                        return EXIT_FAILURE;
+                }
+
+                Token token;
+                while (lexing && LexerStreamNext(&stream, &token)) {
+                        u32 line, column;
+                        LexerStreamPosition(&stream, token, &line, &column);
+                        PrintToken(token, line, column);
+                        lexing = (token.type != Token_EndOfStream && token.type != Token_Unknown);
+                }
+                fflush(stdout);
+        }
+
+        LexerStreamDeinit(&stream);
+        return EXIT_SUCCESS;
+}
+
+/* How many lexing errors --recover reports; later ones are only counted. */
+#define MAX_DIAGNOSTICS 1024
+
+void PrintDiagnostics(LexerDiagnostics *diagnostics, LexerLines *lines, char *source) {
+        for (u32 i = 0; i < diagnostics->num_entries; i++) {
+                LexerDiagnostic diagnostic = diagnostics->entries[i];
+                u32 line, column;
+                LexerLinesFind(lines, source + diagnostic.offset, &line, &column);
+                fprintf(stderr, "[%u,%u] %s: %.*s\n",
+                        line,
+                        column,
+                        LexerDiagnosticString(diagnostic.kind),
+                        diagnostic.length,
+                        source + diagnostic.offset);
+        }
+        if (diagnostics->num_dropped > 0) {
+                fprintf(stderr, "%u more errors not shown\n", diagnostics->num_dropped);
+        }
+}
+
 int main(int argc, char **argv) {
         const char *prog_name = argv[0];
 
@@ -46,13 +114,40 @@ int main(int argc, char **argv) {
                 Usage(prog_name);
 
         char *filename = argv[2];
+
+        gs_Allocator allocator = { .malloc = malloc, .free = free, .realloc = realloc, .calloc = calloc };
+        ParserContext context;
+        ParserContextInit(&context, allocator);
+
+        bool flat = false;
+        bool recover = false;
+        u32 num_threads = 1;
+        for (int i = 3; i < argc; i++) {
+                if (gs_StringIsEqual(argv[i], "--memoize", 9))
+                        ParserSetMemoization(&context, true);
+                else if (gs_StringIsEqual(argv[i], "--flat", 6))
+                        flat = true;
+                else if (gs_StringIsEqual(argv[i], "--compact", 9))
+                        ParserSetCompaction(&context, true);
+                else if (gs_StringIsEqual(argv[i], "--threads", 9) && i + 1 < argc)
+                        num_threads = (u32)atoi(argv[++i]);
+                else if (gs_StringIsEqual(argv[i], "--recover", 9))
+                        recover = true;
+                else
+                        Usage(prog_name);
+        }
+
+        if (gs_StringIsEqual(command, "lex", 3) && gs_StringIsEqual(filename, "-", 2)) {
+                return LexStandardInput(&context.lexer);
+        }
+
         struct stat stat_buf;
         if (stat(filename, &stat_buf) != 0) {
                 fprintf(stderr, "%s\n", strerror(errno));
                 exit(EXIT_FAILURE);
         }
 
-        char *buf_start = (char *)malloc(stat_buf.st_size);
+        char *buf_start = (char *)malloc(stat_buf.st_size + 1); /* Room for the terminating NUL. */
         gs_Buffer buffer;
         gs_BufferInit(&buffer, buf_start, stat_buf.st_size);
 
@@ -69,34 +164,67 @@ int main(int argc, char **argv) {
 
         fclose(file);
 
-        gs_Allocator allocator = { .malloc = malloc, .free = free, .realloc = realloc, .calloc = calloc };
+        LexerLines lines;
+        if (!LexerLinesInit(&lines, &context.lexer, buffer.start, buffer.length)) {
+                fprintf(stderr, "%s\n", LexerErrorString(&context.lexer));
+                exit(EXIT_FAILURE);
+        }
+        u32 line, column;
 
-        if (gs_StringIsEqual(command, "parse", 5)) {
+        if (gs_StringIsEqual(command, "parse", 5) && flat) {
+                ParseFlatTree flat_tree;
+                Tokenizer tokenizer;
+                if (ParseFlat(&context, &buffer, &flat_tree, &tokenizer)) {
+                        ParseFlatTreePrint(&flat_tree, &lines, 0, 0, 2, printf);
+                        ParseFlatTreeDeinit(&flat_tree);
+                } else {
+                        LexerLinesFind(&lines, tokenizer.at, &line, &column);
+                        printf("Input did not parse @ [%d,%d]\n", line, column);
+                }
+        } else if (gs_StringIsEqual(command, "parse", 5)) {
                 ParseTreeNode *parse_tree;
                 Tokenizer tokenizer;
-                if (Parse(allocator, &buffer, &parse_tree, &tokenizer)) {
-                        ParseTreePrint(parse_tree, 0, 2, printf);
+                if (Parse(&context, &buffer, &parse_tree, &tokenizer)) {
+                        ParseTreePrint(parse_tree, &lines, 0, 2, printf);
                 } else {
-                        printf("Input did not parse @ [%d,%d]\n", tokenizer.line, tokenizer.column);
+                        LexerLinesFind(&lines, tokenizer.at, &line, &column);
+                        printf("Input did not parse @ [%d,%d]\n", line, column);
                 }
+                ParseTreeDeinit(&context.tree, parse_tree);
+        } else if (recover) {
+                LexerDiagnostics diagnostics;
+                Token *token_stream;
+                u32 num_tokens;
+                if (LexerDiagnosticsInit(&diagnostics, &context.lexer, MAX_DIAGNOSTICS) &&
+                    LexWithDiagnostics(&context.lexer, &buffer, &diagnostics, &token_stream, &num_tokens)) {
+                        for (int i = 0; i < num_tokens; i++) {
+                                Token token = token_stream[i];
+                                LexerLinesFind(&lines, token.text, &line, &column);
+                                PrintToken(token, line, column);
+                        }
+                        PrintDiagnostics(&diagnostics, &lines, buffer.start);
+                } else {
+                        fprintf(stderr, "%s\n", LexerErrorString(&context.lexer));
+                }
+                LexerDiagnosticsDeinit(&diagnostics);
         } else {
                 Token *token_stream;
                 u32 num_tokens;
-                if (Lex(allocator, &buffer, &token_stream, &num_tokens)) {
+                bool lexed = (num_threads == 1) ?
+                        Lex(&context.lexer, &buffer, &token_stream, &num_tokens) :
+                        LexParallel(&context.lexer, &buffer, num_threads, &token_stream, &num_tokens);
+                if (lexed) {
                         for (int i = 0; i < num_tokens; i++) {
                                 Token token = token_stream[i];
-
-                                printf("[%u,%u] Token Name: %20s, Token Text: %.*s\n",
-                                       token.line + 1,
-                                       token.column,
-                                       TokenName(token.type),
-                                       (u32)(token.text_length),
-                                       token.text);
+                                LexerLinesFind(&lines, token.text, &line, &column);
+                                PrintToken(token, line, column);
                         }
                 } else {
-                        fprintf(stderr, LexerErrorString());
+                        fprintf(stderr, LexerErrorString(&context.lexer));
                 }
         }
 
+        LexerLinesDeinit(&lines);
+        ParserContextDeinit(&context);
         return EXIT_SUCCESS;
 }
@@ -86,27 +86,17 @@ typedef enum ParseTreeNodeType {
         ParseTreeNode_UnaryExpression,
         ParseTreeNode_UnaryOperator,
 
-        ParseTreeNode_AdditiveExpressionI,
-        ParseTreeNode_AndExpressionI,
         ParseTreeNode_ArgumentExpressionListI,
         ParseTreeNode_DeclarationListI,
         ParseTreeNode_DirectAbstractDeclaratorI,
         ParseTreeNode_DirectDeclaratorI,
         ParseTreeNode_EnumeratorListI,
-        ParseTreeNode_EqualityExpressionI,
-        ParseTreeNode_ExclusiveOrExpressionI,
         ParseTreeNode_ExpressionI,
         ParseTreeNode_IdentifierListI,
-        ParseTreeNode_InclusiveOrExpressionI,
         ParseTreeNode_InitDeclaratorListI,
         ParseTreeNode_InitializerListI,
-        ParseTreeNode_LogicalAndExpressionI,
-        ParseTreeNode_LogicalOrExpressionI,
-        ParseTreeNode_MultiplicativeExpressionI,
         ParseTreeNode_ParameterListI,
         ParseTreeNode_PostfixExpressionI,
-        ParseTreeNode_RelationalExpressionI,
-        ParseTreeNode_ShiftExpressionI,
         ParseTreeNode_StatementListI,
         ParseTreeNode_StructDeclarationListI,
         ParseTreeNode_StructDeclaratorListI,
@@ -188,27 +178,17 @@ char *__parse_tree_node_type_names[] = {
         "UnaryExpression",
         "UnaryOperator",
 
-        "AdditiveExpression'",
-        "AndExpression'",
         "ArgumentExpressionList'",
         "DeclarationList'",
         "DirectAbstractDeclarator'",
         "DirectDeclarator'",
         "EnumeratorList'",
-        "EqualityExpression'",
-        "ExclusiveOrExpression'",
         "Expression'",
         "IdentifierList'",
-        "InclusiveOrExpression'",
         "InitDeclaratorList'",
         "InitializerList'",
-        "LogicalAndExpression'",
-        "LogicalOrExpression'",
-        "MultiplicativeExpression'",
         "ParameterList'",
         "PostfixExpression'",
-        "RelationalExpression'",
-        "ShiftExpression'",
         "StatementList'",
         "StructDeclarationList'",
         "StructDeclaratorList'",
@@ -226,60 +206,116 @@ char *ParseTreeNodeName(ParseTreeNodeType type) {
         return __parse_tree_node_type_names[type];
 }
 
-static gs_Allocator __parse_tree_allocator;
+#define PARSE_TREE_ARENA_BLOCK_SIZE (64 * 1024)
 
 typedef struct ParseTreeNode {
         ParseTreeNodeType type;
+        bool in_arena; /* Taken from its context's arena; children inherit this. */
         Token token;
         gs_TreeNode tree;
 } ParseTreeNode;
 
 typedef enum ParseTreeErrorEnum {
         ParseTreeErrorChildAlloc,
+        ParseTreeErrorRootAlloc,
         ParseTreeErrorNone,
 } ParseTreeErrorEnum;
 
 const char *__parse_tree_error_strings[] = {
         "Couldn't allocate memory for new child node",
+        "Couldn't allocate memory for new tree",
         "No error",
 };
 
-ParseTreeErrorEnum __parse_tree_last_error = ParseTreeErrorNone;
+/*
+  Where a caller's trees are allocated and their errors reported. Trees built
+  with different contexts share nothing, so they can be built at once.
+*/
+typedef struct ParseTreeContext {
+        gs_Allocator allocator;
+        gs_Arena arena;
+        u32 arena_trees; /* Trees alive in the arena. */
+        ParseTreeErrorEnum last_error;
+} ParseTreeContext;
+
+void ParseTreeContextInit(ParseTreeContext *context, gs_Allocator allocator) {
+        context->allocator = allocator;
+        gs_ArenaInit(&context->arena, allocator, PARSE_TREE_ARENA_BLOCK_SIZE);
+        context->arena_trees = 0;
+        context->last_error = ParseTreeErrorNone;
+}
 
-const char *ParseTreeErrorString() {
-        const char *result = __parse_tree_error_strings[__parse_tree_last_error];
-        __parse_tree_last_error = ParseTreeErrorNone;
+const char *ParseTreeErrorString(ParseTreeContext *context) {
+        const char *result = __parse_tree_error_strings[context->last_error];
+        context->last_error = ParseTreeErrorNone;
 
         return result;
 }
 
-void __ParseTreeInit(ParseTreeNode *node) {
+void __ParseTreeInit(ParseTreeContext *context, ParseTreeNode *node) {
+        node->in_arena = false;
         node->token.text = NULL;
         node->token.text_length = 0;
         node->token.type = Token_Unknown;
-        node->token.line = 0;
-        node->token.column = 0;
+        node->token.symbol = LEXER_NO_SYMBOL;
 
         node->type = ParseTreeNode_Unknown;
-        gs_TreeInit(&(node->tree), __parse_tree_allocator);
+        gs_TreeInit(&(node->tree), context->allocator);
 
         return;
 }
 
-ParseTreeNode *ParseTreeInit(gs_Allocator allocator) {
-        __parse_tree_allocator = allocator;
-        ParseTreeNode *node = (ParseTreeNode *)allocator.malloc(sizeof(*node));
-        __ParseTreeInit(node);
+ParseTreeNode *__ParseTreeAlloc(ParseTreeContext *context, bool in_arena) {
+        ParseTreeNode *node = (ParseTreeNode *)(in_arena ?
+                gs_ArenaAlloc(&context->arena, sizeof(*node)) :
+                context->allocator.malloc(sizeof(*node)));
+        if (node == GS_NULL_PTR) return GS_NULL_PTR;
+
+        __ParseTreeInit(context, node);
+        node->in_arena = in_arena;
+
         return node;
 }
 
+void __ParseTreeFree(ParseTreeContext *context, ParseTreeNode *node) {
+        if (!node->in_arena) context->allocator.free(node);
+}
+
+ParseTreeNode *ParseTreeInit(ParseTreeContext *context) {
+        ParseTreeNode *root = __ParseTreeAlloc(context, false);
+        if (root == GS_NULL_PTR) context->last_error = ParseTreeErrorRootAlloc;
+
+        return root;
+}
+
+/*
+  Like ParseTreeInit, but every node of the tree is bump-allocated from the
+  context's arena. Removing children frees nothing; trees created this way
+  share the arena, which is released in one go when the last of them is passed
+  to ParseTreeDeinit. Heap trees from ParseTreeInit can live alongside them:
+  each node is allocated the way its tree's root was.
+*/
+ParseTreeNode *ParseTreeInitArena(ParseTreeContext *context) {
+        if (context->arena_trees == 0) {
+                gs_ArenaInit(&context->arena, context->allocator, PARSE_TREE_ARENA_BLOCK_SIZE);
+        }
+        context->arena_trees++;
+
+        ParseTreeNode *root = __ParseTreeAlloc(context, true);
+        if (root == GS_NULL_PTR) {
+                context->last_error = ParseTreeErrorRootAlloc;
+                if (--context->arena_trees == 0) gs_ArenaDeinit(&context->arena);
+        }
+
+        return root;
+}
+
 void ParseTreeSetToken(ParseTreeNode *node, Token token) {
         Token *this = &(node->token);
         this->text = token.text;
         this->text_length = token.text_length;
         this->type = token.type;
-        this->line = token.line;
-        this->column = token.column;
+        this->symbol = token.symbol;
 }
 
 void ParseTreeSet(ParseTreeNode *self, ParseTreeNodeType type, Token token) {
@@ -287,90 +323,215 @@ void ParseTreeSet(ParseTreeNode *self, ParseTreeNodeType type, Token token) {
         ParseTreeSetToken(self, token);
 }
 
-ParseTreeNode *ParseTreeAddChild(ParseTreeNode *self) {
-        gs_TreeNode *child_tree = gs_TreeAddChild(&self->tree, ParseTreeNode, tree, __parse_tree_allocator);
-        if (child_tree == GS_NULL_PTR) {
-                // TODO: Error handling
+ParseTreeNode *ParseTreeAddChild(ParseTreeContext *context, ParseTreeNode *self) {
+        ParseTreeNode *child = __ParseTreeAlloc(context, self->in_arena);
+        if (child == GS_NULL_PTR) {
+                context->last_error = ParseTreeErrorChildAlloc;
                 return GS_NULL_PTR;
         }
-        ParseTreeNode *child = gs_TreeContainer(child_tree, ParseTreeNode, tree);
-        __ParseTreeInit(child);
+        gs_TreeAppendChild(&self->tree, &child->tree);
 
         return child;
 }
 
+/*
+  Sets dest's type and token from source and appends deep copies of source's
+  children to dest. Source's siblings are not copied.
+*/
+void ParseTreeCopy(ParseTreeContext *context, ParseTreeNode *dest, ParseTreeNode *source) {
+        ParseTreeSet(dest, source->type, source->token);
+
+        gs_TreeNode *child = source->tree.child;
+        while (child != GS_NULL_PTR) {
+                ParseTreeNode *copy = ParseTreeAddChild(context, dest);
+                ParseTreeCopy(context, copy, gs_TreeContainer(child, ParseTreeNode, tree));
+                child = child->sibling;
+        }
+}
+
 // TODO: Move to gs.h
-bool __ParseTreeRecursiveDestroy(ParseTreeNode *parse_node) {
+bool __ParseTreeRecursiveDestroy(ParseTreeContext *context, ParseTreeNode *parse_node) {
         gs_TreeNode *tree_node = &parse_node->tree;
 
         gs_TreeNode *child = tree_node->child;
         if (child != GS_NULL_PTR) {
-                __ParseTreeRecursiveDestroy(gs_TreeContainer(child, ParseTreeNode, tree));
+                __ParseTreeRecursiveDestroy(context, gs_TreeContainer(child, ParseTreeNode, tree));
         }
 
         gs_TreeNode *sibling = tree_node->sibling;
         if (sibling != GS_NULL_PTR) {
-                __ParseTreeRecursiveDestroy(gs_TreeContainer(sibling, ParseTreeNode, tree));
+                __ParseTreeRecursiveDestroy(context, gs_TreeContainer(sibling, ParseTreeNode, tree));
         }
 
-        __parse_tree_allocator.free(parse_node);
+        __ParseTreeFree(context, parse_node);
 }
 
-void ParseTreeRemoveAllChildren(ParseTreeNode *node) {
+void ParseTreeRemoveAllChildren(ParseTreeContext *context, ParseTreeNode *node) {
         gs_TreeNode *child = node->tree.child;
         if (child == GS_NULL_PTR) {
                 return;
         }
 
-        __ParseTreeRecursiveDestroy(gs_TreeContainer(child, ParseTreeNode, tree));
+        /* Arena nodes aren't freed one by one, so there's nothing to walk. */
+        if (!node->in_arena) {
+                __ParseTreeRecursiveDestroy(context, gs_TreeContainer(child, ParseTreeNode, tree));
+        }
 
-        node->tree.child = GS_NULL_PTR;
+        gs_TreeDetachChildren(&node->tree);
 }
 
-// TODO: Move to gs.h
-bool ParseTreeRemoveChild(ParseTreeNode *node, ParseTreeNode *child) {
-        gs_TreeNode *current = node->tree.child;
-        if (current == GS_NULL_PTR) {
-                return false;
+gs_ArenaMark ParseTreeGetMark(ParseTreeContext *context) {
+        return gs_ArenaGetMark(&context->arena);
+}
+
+/*
+  Removes all of self's children. When self is in the arena, everything
+  allocated since `mark' is reclaimed at once instead of node by node, so
+  self's children must be the only nodes created since the mark was taken.
+*/
+void ParseTreeRollback(ParseTreeContext *context, ParseTreeNode *self, gs_ArenaMark mark) {
+        if (!self->in_arena) {
+                ParseTreeRemoveAllChildren(context, self);
+                return;
+        }
+
+        gs_TreeDetachChildren(&self->tree);
+        gs_ArenaRollback(&context->arena, mark);
+}
+
+/*
+  Moves self's type, token and children into a new node that becomes self's
+  only child, leaving self itself unset. Returns the new child.
+*/
+ParseTreeNode *ParseTreePushDown(ParseTreeContext *context, ParseTreeNode *self) {
+        gs_TreeNode children;
+        gs_TreeMoveChildren(&children, &self->tree);
+
+        ParseTreeNode *child = ParseTreeAddChild(context, self);
+        ParseTreeSet(child, self->type, self->token);
+        gs_TreeMoveChildren(&child->tree, &children);
+
+        Token unset = { .text = GS_NULL_PTR, .type = Token_Unknown, .symbol = LEXER_NO_SYMBOL };
+        ParseTreeSet(self, ParseTreeNode_Unknown, unset);
+
+        return child;
+}
+
+/*
+  Undoes ParseTreePushDown: self takes back its first child's type, token and
+  children, and any other children are destroyed.
+*/
+void ParseTreePullUp(ParseTreeContext *context, ParseTreeNode *self) {
+        gs_TreeNode *first = self->tree.child;
+        if (first == GS_NULL_PTR) {
+                return;
+        }
+
+        if (first->sibling != GS_NULL_PTR) {
+                __ParseTreeRecursiveDestroy(context, gs_TreeContainer(first->sibling, ParseTreeNode, tree));
         }
 
+        ParseTreeNode *child = gs_TreeContainer(first, ParseTreeNode, tree);
+        ParseTreeSet(self, child->type, child->token);
+        gs_TreeMoveChildren(&self->tree, first);
+
+        __ParseTreeFree(context, child);
+}
+
+bool ParseTreeNodeIsTail(ParseTreeNodeType type) {
+        return type >= ParseTreeNode_ArgumentExpressionListI && type <= ParseTreeNode_TypeQualifierListI;
+}
+
+void __ParseTreeCompactChildren(ParseTreeContext *context, ParseTreeNode *self) {
+        gs_TreeNode *child = self->tree.child;
+        gs_TreeDetachChildren(&self->tree);
+
+        while (child != GS_NULL_PTR) {
+                gs_TreeNode *next = child->sibling;
+                ParseTreeNode *node = gs_TreeContainer(child, ParseTreeNode, tree);
+                __ParseTreeCompactChildren(context, node);
+
+                bool has_token = node->token.type != Token_Unknown;
+                u32 num_children = gs_TreeNumChildren(&node->tree);
+
+                if ((node->type == ParseTreeNode_Unknown && !has_token) ||
+                    (!has_token && num_children == 1) ||
+                    (ParseTreeNodeIsTail(node->type) && num_children == 0)) {
+                        gs_TreeNode *grandchild = node->tree.child;
+                        while (grandchild != GS_NULL_PTR) {
+                                gs_TreeNode *following = grandchild->sibling;
+                                gs_TreeAppendChild(&self->tree, grandchild);
+                                grandchild = following;
+                        }
+                        __ParseTreeFree(context, node);
+                } else {
+                        gs_TreeAppendChild(&self->tree, child);
+                }
+
+                child = next;
+        }
+}
+
+/*
+  Rewrites the tree below self in place into a smaller one holding the same
+  tokens in the same order: unset placeholder nodes are replaced by their
+  children, tail nodes of empty productions are dropped, and a node without a
+  token that has exactly one child is replaced by that child. Self keeps its
+  own type and token.
+*/
+void ParseTreeCompact(ParseTreeContext *context, ParseTreeNode *self) {
+        __ParseTreeCompactChildren(context, self);
+}
+
+// TODO: Move to gs.h
+bool ParseTreeRemoveChild(ParseTreeContext *context, ParseTreeNode *node, ParseTreeNode *child) {
         gs_TreeNode *last = GS_NULL_PTR;
-        while (current->sibling != GS_NULL_PTR) {
-                ParseTreeNode *container = gs_TreeContainer(current, ParseTreeNode, tree);
-                if (container == child) {
+        for (gs_TreeNode *current = node->tree.child; current != GS_NULL_PTR; current = current->sibling) {
+                if (gs_TreeContainer(current, ParseTreeNode, tree) == child) {
                         if (last == GS_NULL_PTR) {
-                                node->tree.child = GS_NULL_PTR;
+                                node->tree.child = current->sibling;
                         } else {
                                 last->sibling = current->sibling;
                         }
-                        __ParseTreeRecursiveDestroy(child);
+                        if (node->tree.last_child == current) {
+                                node->tree.last_child = last;
+                        }
+                        node->tree.num_children--;
+
+                        current->sibling = GS_NULL_PTR;
+                        __ParseTreeRecursiveDestroy(context, child);
 
                         return true;
                 }
                 last = current;
-                current = current->sibling;
         }
 
         return false;
 }
 
-void __ParseTreeDeinit(void *ptr) {
-        ParseTreeNode *self = (ParseTreeNode *)ptr;
-        __parse_tree_allocator.free(self);
-}
-
-void ParseTreeDeinit(ParseTreeNode *self) {
+void ParseTreeDeinit(ParseTreeContext *context, ParseTreeNode *self) {
         if (self == NULL) {
                 return;
         }
 
-        gs_TreeDeinit(&self->tree, ParseTreeNode, tree, __ParseTreeDeinit);
+        if (self->in_arena) {
+                context->arena_trees--;
+                if (context->arena_trees == 0) {
+                        gs_ArenaDeinit(&context->arena);
+                }
+                return;
+        }
+
+        __ParseTreeRecursiveDestroy(context, self);
 }
 
-void ParseTreePrint(ParseTreeNode *self, u32 indent_level, u32 indent_increment, int (*print_func)(const char *format, ...)) {
+/* `lines' indexes the buffer the tree was parsed from and is used to print token positions. */
+void ParseTreePrint(ParseTreeNode *self, LexerLines *lines, u32 indent_level, u32 indent_increment, int (*print_func)(const char *format, ...)) {
         if (self->type != ParseTreeNode_Unknown) {
                 if (self->token.type != Token_Unknown) {
-                        print_func("[%4d,%3d] ", self->token.line, self->token.column);
+                        u32 line, column;
+                        LexerLinesFind(lines, self->token.text, &line, &column);
+                        print_func("[%4d,%3d] ", line, column);
                 } else {
                         print_func("           ");
                 }
@@ -388,12 +549,241 @@ void ParseTreePrint(ParseTreeNode *self, u32 indent_level, u32 indent_increment,
 
         if (self->tree.child != GS_NULL_PTR) {
                 ParseTreeNode *child = gs_TreeContainer(self->tree.child, ParseTreeNode, tree);
-                ParseTreePrint(child, indent_level + 1, indent_increment, print_func);
+                ParseTreePrint(child, lines, indent_level + 1, indent_increment, print_func);
         }
 
         if (self->tree.sibling != GS_NULL_PTR) {
                 ParseTreeNode *sibling = gs_TreeContainer(self->tree.sibling, ParseTreeNode, tree);
-                ParseTreePrint(sibling, indent_level, indent_increment, print_func);
+                ParseTreePrint(sibling, lines, indent_level, indent_increment, print_func);
+        }
+}
+
+/*
+  Flat parse tree: the shape of a ParseTreeNode tree kept in parallel u32
+  arrays indexed by node, in pre-order with the root at index 0. Links are
+  node indices and tokens are indices into `tokens', so the arrays hold no
+  pointers and can be copied or written out as they are. Each node costs 16
+  bytes.
+*/
+#define PARSE_FLAT_TREE_NONE 0xFFFFFFFF
+
+typedef struct ParseFlatTree {
+        u32 *kind; /* ParseTreeNodeType */
+        u32 *first_child;
+        u32 *next_sibling;
+        u32 *token_index;
+        u32 num_nodes;
+        u32 capacity;
+
+        TokenStream tokens; /* Owned; sorted by position in the source. */
+        gs_Allocator allocator;
+} ParseFlatTree;
+
+u32 __ParseFlatTreeCount(ParseTreeNode *node) {
+        u32 count = 1;
+        for (gs_TreeNode *child = node->tree.child; child != GS_NULL_PTR; child = child->sibling) {
+                count += __ParseFlatTreeCount(gs_TreeContainer(child, ParseTreeNode, tree));
+        }
+        return count;
+}
+
+/* Tokens are ordered by position, so their offsets are too. */
+u32 __ParseFlatTreeTokenIndex(ParseFlatTree *self, Token token) {
+        if (token.type == Token_Unknown) return PARSE_FLAT_TREE_NONE;
+
+        u32 *offsets = self->tokens.offset;
+        u32 offset = (u32)(token.text - self->tokens.source);
+        u32 low = 0, high = self->tokens.num_tokens;
+        while (low < high) {
+                u32 middle = low + (high - low) / 2;
+                if (offsets[middle] < offset) low = middle + 1;
+                else high = middle;
+        }
+
+        if (low < self->tokens.num_tokens && offsets[low] == offset) return low;
+        return PARSE_FLAT_TREE_NONE;
+}
+
+/* The four arrays share one allocation, so growing moves each of them. */
+bool __ParseFlatTreeReserve(ParseFlatTree *self, u32 num_nodes) {
+        if (self->num_nodes + num_nodes <= self->capacity) return true;
+
+        u32 capacity = gs_Max(gs_Max(self->capacity * 2, self->num_nodes + num_nodes), 256);
+        u32 *arrays = (u32 *)self->allocator.malloc(sizeof(u32) * 4 * (u64)capacity);
+        if (arrays == GS_NULL_PTR) return false;
+
+        u32 *old[4] = { self->kind, self->first_child, self->next_sibling, self->token_index };
+        for (u32 i = 0; i < 4; i++) {
+                if (self->num_nodes > 0) gs_MemCopy(old[i], arrays + capacity * i, sizeof(u32) * self->num_nodes);
+        }
+        self->allocator.free(self->kind);
+
+        self->kind = arrays;
+        self->first_child = arrays + capacity;
+        self->next_sibling = arrays + capacity * 2;
+        self->token_index = arrays + capacity * 3;
+        self->capacity = capacity;
+
+        return true;
+}
+
+u32 __ParseFlatTreeAppend(ParseFlatTree *self, ParseTreeNode *node) {
+        u32 index = self->num_nodes++;
+        self->kind[index] = node->type;
+        self->token_index[index] = __ParseFlatTreeTokenIndex(self, node->token);
+        self->first_child[index] = PARSE_FLAT_TREE_NONE;
+        self->next_sibling[index] = PARSE_FLAT_TREE_NONE;
+
+        u32 previous = PARSE_FLAT_TREE_NONE;
+        for (gs_TreeNode *child = node->tree.child; child != GS_NULL_PTR; child = child->sibling) {
+                u32 child_index = __ParseFlatTreeAppend(self, gs_TreeContainer(child, ParseTreeNode, tree));
+                if (previous == PARSE_FLAT_TREE_NONE) self->first_child[index] = child_index;
+                else self->next_sibling[previous] = child_index;
+                previous = child_index;
+        }
+
+        return index;
+}
+
+/*
+  Starts an empty flat tree over `tokens', the token stream its nodes will be
+  parsed from, and takes ownership of it.
+*/
+void ParseFlatTreeInit(ParseFlatTree *self, gs_Allocator allocator, TokenStream *tokens) {
+        self->allocator = allocator;
+        self->tokens = *tokens;
+        self->kind = self->first_child = self->next_sibling = self->token_index = GS_NULL_PTR;
+        self->num_nodes = 0;
+        self->capacity = 0;
+}
+
+/*
+  Appends a flat copy of `node' and the tree below it, which must have been
+  parsed from the flat tree's tokens. The copy isn't linked to any node
+  already there. Returns its index, or PARSE_FLAT_TREE_NONE if out of memory.
+*/
+u32 ParseFlatTreeAppend(ParseFlatTree *self, ParseTreeNode *node) {
+        if (!__ParseFlatTreeReserve(self, __ParseFlatTreeCount(node))) return PARSE_FLAT_TREE_NONE;
+        return __ParseFlatTreeAppend(self, node);
+}
+
+void ParseFlatTreeDeinit(ParseFlatTree *self) {
+        self->allocator.free(self->kind);
+        TokenStreamDeinit(&self->tokens);
+        self->kind = self->first_child = self->next_sibling = self->token_index = GS_NULL_PTR;
+        self->num_nodes = 0;
+        self->capacity = 0;
+}
+
+/*
+  Decides which of node's descendants ParseTreeCompact would drop, marking
+  them in `removed', and returns how many children node keeps.
+*/
+u32 __ParseFlatTreeCompactCount(ParseFlatTree *self, u32 node, bool *removed) {
+        u32 count = 0;
+        for (u32 child = self->first_child[node]; child != PARSE_FLAT_TREE_NONE; child = self->next_sibling[child]) {
+                u32 num_children = __ParseFlatTreeCompactCount(self, child, removed);
+                bool has_token = self->token_index[child] != PARSE_FLAT_TREE_NONE;
+
+                removed[child] = (self->kind[child] == ParseTreeNode_Unknown && !has_token) ||
+                                 (!has_token && num_children == 1) ||
+                                 (ParseTreeNodeIsTail(self->kind[child]) && num_children == 0);
+                count += removed[child] ? num_children : 1;
+        }
+        return count;
+}
+
+/* Copies the kept nodes below `node' into `dest' as children of `parent', after `*last'. */
+void __ParseFlatTreeCompactCopy(ParseFlatTree *self, ParseFlatTree *dest, u32 node, bool *removed, u32 parent, u32 *last) {
+        for (u32 child = self->first_child[node]; child != PARSE_FLAT_TREE_NONE; child = self->next_sibling[child]) {
+                if (removed[child]) {
+                        __ParseFlatTreeCompactCopy(self, dest, child, removed, parent, last);
+                        continue;
+                }
+
+                u32 index = dest->num_nodes++;
+                dest->kind[index] = self->kind[child];
+                dest->token_index[index] = self->token_index[child];
+                dest->first_child[index] = PARSE_FLAT_TREE_NONE;
+                dest->next_sibling[index] = PARSE_FLAT_TREE_NONE;
+
+                if (*last == PARSE_FLAT_TREE_NONE) dest->first_child[parent] = index;
+                else dest->next_sibling[*last] = index;
+                *last = index;
+
+                u32 child_last = PARSE_FLAT_TREE_NONE;
+                __ParseFlatTreeCompactCopy(self, dest, child, removed, index, &child_last);
+        }
+}
+
+/*
+  Rewrites the tree into the one ParseTreeCompact would leave: the same nodes
+  in the same order, minus placeholders, empty tails and token-less nodes
+  with a single child. Returns false, leaving the tree as it was, if out of
+  memory.
+*/
+bool ParseFlatTreeCompact(ParseFlatTree *self) {
+        if (self->num_nodes == 0) return true;
+
+        bool *removed = (bool *)self->allocator.calloc(self->num_nodes, sizeof(bool));
+        if (removed == GS_NULL_PTR) return false;
+
+        __ParseFlatTreeCompactCount(self, 0, removed);
+        u32 num_kept = 0;
+        for (u32 i = 0; i < self->num_nodes; i++) {
+                if (!removed[i]) num_kept++;
+        }
+
+        ParseFlatTree compact;
+        ParseFlatTreeInit(&compact, self->allocator, &self->tokens);
+        if (!__ParseFlatTreeReserve(&compact, num_kept)) {
+                self->allocator.free(removed);
+                return false;
+        }
+
+        compact.num_nodes = 1;
+        compact.kind[0] = self->kind[0];
+        compact.token_index[0] = self->token_index[0];
+        compact.first_child[0] = PARSE_FLAT_TREE_NONE;
+        compact.next_sibling[0] = PARSE_FLAT_TREE_NONE;
+        u32 last = PARSE_FLAT_TREE_NONE;
+        __ParseFlatTreeCompactCopy(self, &compact, 0, removed, 0, &last);
+
+        self->allocator.free(removed);
+        self->allocator.free(self->kind);
+        *self = compact;
+
+        return true;
+}
+
+/* Prints the subtree at `node' and its following siblings like ParseTreePrint. */
+void ParseFlatTreePrint(ParseFlatTree *self, LexerLines *lines, u32 node, u32 indent_level, u32 indent_increment, int (*print_func)(const char *format, ...)) {
+        for (; node != PARSE_FLAT_TREE_NONE; node = self->next_sibling[node]) {
+                if (self->kind[node] != ParseTreeNode_Unknown) {
+                        Token token;
+                        bool has_token = self->token_index[node] != PARSE_FLAT_TREE_NONE;
+                        if (has_token) token = TokenStreamGet(&self->tokens, self->token_index[node]);
+
+                        if (has_token) {
+                                u32 line, column;
+                                LexerLinesFind(lines, token.text, &line, &column);
+                                print_func("[%4d,%3d] ", line, column);
+                        } else {
+                                print_func("           ");
+                        }
+
+                        if (indent_level > 0) print_func("%*c", indent_level * indent_increment, ' ');
+
+                        print_func("%s", ParseTreeNodeName(self->kind[node]));
+
+                        if (has_token) {
+                                print_func("( %.*s )", (u32)(token.text_length), token.text);
+                        }
+
+                        print_func("\n");
+                }
+
+                ParseFlatTreePrint(self, lines, self->first_child[node], indent_level + 1, indent_increment, print_func);
         }
 }
 
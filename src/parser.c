@@ -26,7 +26,7 @@
 #include "lexer.c"
 #include "parse_tree.c"
 
-gs_Allocator __parser_allocator;
+typedef struct ParserContext ParserContext;
 
 void __parser_ParseTreeClearChildren(ParseTreeNode *node) {
         gs_TreeNode *tree_node = &node->tree;
@@ -37,80 +37,368 @@ void __parser_ParseTreeClearChildren(ParseTreeNode *node) {
         }
 }
 
-bool ParseAssignmentExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseTypeName(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseCastExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseConditionalExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseDeclarationList(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseParameterTypeList(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseAbstractDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParsePointer(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseSpecifierQualifierList(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseInitializer(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseDeclarationSpecifiers(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseTypeQualifier(Tokenizer *Tokneizer, ParseTreeNode *parse_tree);
-bool ParseTypeSpecifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-bool ParseDeclaration(Tokenizer *tokenizer, ParseTreeNode *parse_tree);
-
+bool ParseAssignmentExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseTypeName(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseCastExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseUnaryExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseConditionalExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseStatement(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseDeclarationList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseParameterTypeList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseAbstractDeclarator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParsePointer(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseSpecifierQualifierList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseInitializer(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseDeclarationSpecifiers(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseDeclarator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseTypeQualifier(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseTypeSpecifier(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+bool ParseDeclaration(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree);
+
+/* One flag per symbol. */
 typedef struct TypedefNames {
-        char *name;
-        int *name_index;
-        int capacity; /* Total allocated space for Name */
-        int num_names; /* Number of Name */
+        bool *is_name;
+        u32 capacity;
 } TypedefNames;
 
-static TypedefNames __parser_typedef_names;
+/*
+  Packrat memoization of the rules the backtracking alternatives retry most.
+  Each (rule, token index) pair is parsed at most once; later attempts take
+  over the recorded subtree and jump to the recorded end position. The table is
+  dense over the token stream, so it trades memory for linear time and is off
+  by default. It assumes the typedef name table doesn't change during a parse.
+*/
+typedef enum ParseMemoRule {
+        ParseMemo_DeclarationSpecifiers,
+        ParseMemo_Declarator,
+        ParseMemo_TypeName,
+        ParseMemo_UnaryExpression,
+        ParseMemo_CastExpression,
+        ParseMemo_LogicalOrExpression,
+        ParseMemo_AssignmentExpression,
+        ParseMemo_Count,
+} ParseMemoRule;
+
+typedef struct ParseMemoEntry {
+        bool success;
+        Tokenizer end; /* Tokenizer state after a successful parse. */
+        ParseTreeNode subtree; /* The node the rule produced; its children are shared, not owned. */
+} ParseMemoEntry;
+
+typedef struct ParseMemo {
+        u32 *slots; /* ParseMemo_Count * num_positions; 0 if untried, else entry index + 1. */
+        u32 num_positions;
+        u32 end_position; /* One past the furthest position with a slot set. */
+        ParseMemoEntry *entries;
+        u32 num_entries;
+        u32 capacity;
+} ParseMemo;
+
+/*
+  Everything a parse reads or changes besides its input: the allocator, the
+  typedef names, the interned identifiers, the memo table, options, and the
+  lexer's and parse tree's own state and errors. Parses with different
+  contexts share nothing, so each thread of a process can run its own; one
+  context runs one parse at a time. Interned identifiers persist across its
+  parses, and the trees it builds are released with ParseTreeDeinit on
+  `&context->tree'.
+*/
+struct ParserContext {
+        gs_Allocator allocator;
+        LexerContext lexer;
+        ParseTreeContext tree;
+
+        /*
+          Identifiers are interned so the parser compares names by symbol.
+          Unless the caller supplies a table with ParserSetSymbols, the
+          context keeps its own, so IDs stay stable across files.
+        */
+        LexerSymbols own_symbols;
+        bool has_own_symbols;
+        LexerSymbols *symbols;
+
+        TypedefNames typedef_names;
+
+        bool memoize;
+        ParseMemo memo;
+
+        bool compact; /* When set, successful parses are run through ParseTreeCompact. */
+};
+
+void ParserContextInit(ParserContext *context, gs_Allocator allocator) {
+        context->allocator = allocator;
+        LexerContextInit(&context->lexer, allocator);
+        ParseTreeContextInit(&context->tree, allocator);
+
+        context->has_own_symbols = false;
+        context->symbols = GS_NULL_PTR;
+
+        context->typedef_names.is_name = GS_NULL_PTR;
+        context->typedef_names.capacity = 0;
+
+        context->memoize = false;
+        context->memo.slots = GS_NULL_PTR;
+        context->memo.num_positions = 0;
+        context->memo.entries = GS_NULL_PTR;
+        context->memo.num_entries = 0;
+        context->memo.capacity = 0;
 
-void TypedefClear() {
-        __parser_allocator.free((void *)__parser_typedef_names.name);
-        __parser_allocator.free((void *)__parser_typedef_names.name_index);
-        __parser_typedef_names.capacity = 0;
-        __parser_typedef_names.num_names = 0;
+        context->compact = false;
 }
 
-void TypedefInit() {
-        char *Memory = (char *)__parser_allocator.malloc(1024);
-        __parser_typedef_names.name = Memory;
-        __parser_typedef_names.capacity = 1024;
-        __parser_typedef_names.name_index = __parser_allocator.malloc(1024 / 2 * sizeof(int));
-        __parser_typedef_names.num_names = 0;
+void TypedefClear(ParserContext *context);
+
+/* Trees built with the context must have been released already. */
+void ParserContextDeinit(ParserContext *context) {
+        TypedefClear(context);
+        if (context->has_own_symbols) LexerSymbolsDeinit(&context->own_symbols);
+        context->has_own_symbols = false;
+        context->symbols = GS_NULL_PTR;
 }
 
-bool TypedefIsName(Token token) {
-        for (int i = 0; i < __parser_typedef_names.num_names; i++) {
-                if (gs_StringIsEqual(token.text, &__parser_typedef_names.name[__parser_typedef_names.name_index[i]], token.text_length)) {
-                        return true;
-                }
+void ParserSetSymbols(ParserContext *context, LexerSymbols *symbols) {
+        context->symbols = symbols;
+}
+
+/* Null only if the context's own table can't be allocated. */
+LexerSymbols *__parser_Symbols(ParserContext *context) {
+        if (context->symbols == GS_NULL_PTR && !context->has_own_symbols &&
+            LexerSymbolsInit(&context->own_symbols, context->allocator)) {
+                context->has_own_symbols = true;
         }
-        return false;
+        if (context->symbols == GS_NULL_PTR && context->has_own_symbols) {
+                context->symbols = &context->own_symbols;
+        }
+        return context->symbols;
 }
 
-bool TypedefAddName(char *name) {
-        if (__parser_typedef_names.num_names == 0) {
-                gs_StringCopy(name, __parser_typedef_names.name, gs_StringLength(name));
-                __parser_typedef_names.num_names++;
-                return true;
+void TypedefClear(ParserContext *context) {
+        TypedefNames *names = &context->typedef_names;
+        if (names->is_name != GS_NULL_PTR) context->allocator.free(names->is_name);
+        names->is_name = GS_NULL_PTR;
+        names->capacity = 0;
+}
+
+void TypedefInit(ParserContext *context) {
+        TypedefClear(context);
+}
+
+bool TypedefIsName(ParserContext *context, Token token) {
+        u32 symbol = token.symbol;
+        if (symbol == LEXER_NO_SYMBOL) {
+                /* Lexed without interning; a name that was never interned can't be a typedef. */
+                if (context->symbols == GS_NULL_PTR) return false;
+                symbol = LexerSymbolsFind(context->symbols, token.text, token.text_length);
         }
+        return symbol < context->typedef_names.capacity && context->typedef_names.is_name[symbol];
+}
 
-        int current_name_index = __parser_typedef_names.name_index[__parser_typedef_names.num_names - 1];
-        /* NameLength doesn't account for trailing NULL */
-        int name_length = gs_StringLength(&__parser_typedef_names.name[current_name_index]);
-        int used_space = &__parser_typedef_names.name[current_name_index] - __parser_typedef_names.name + name_length + 1;
-        int remaining_capacity = __parser_typedef_names.capacity - used_space;
+bool TypedefAddName(ParserContext *context, char *name) {
+        LexerSymbols *symbols = __parser_Symbols(context);
+        if (symbols == GS_NULL_PTR) return false;
 
-        int new_name_length = gs_StringLength(name);
-        if (new_name_length + 1 > remaining_capacity) {
-                return false;
+        u32 symbol = LexerSymbolsIntern(symbols, name, gs_StringLength(name));
+        if (symbol == LEXER_NO_SYMBOL) return false;
+
+        TypedefNames *names = &context->typedef_names;
+        if (symbol >= names->capacity) {
+                u32 capacity = gs_Max(symbols->capacity, symbol + 1);
+                bool *is_name = (bool *)context->allocator.realloc(names->is_name, sizeof(*is_name) * capacity);
+                if (is_name == GS_NULL_PTR) return false;
+                for (u32 i = names->capacity; i < capacity; i++) is_name[i] = false;
+                names->is_name = is_name;
+                names->capacity = capacity;
         }
 
-        gs_StringCopy(name, &__parser_typedef_names.name[current_name_index] + name_length + 1, gs_StringLength(name));
-        __parser_typedef_names.num_names++;
+        names->is_name[symbol] = true;
+        return true;
+}
+
+void ParserSetMemoization(ParserContext *context, bool enabled) {
+        context->memoize = enabled;
+}
+
+bool ParserMemoizationEnabled(ParserContext *context) {
+        return context->memoize;
+}
+
+void ParserSetCompaction(ParserContext *context, bool enabled) {
+        context->compact = enabled;
+}
+
+bool __parser_MemoInit(ParserContext *context, u32 num_positions) {
+        ParseMemo *memo = &context->memo;
+        memo->slots = context->allocator.calloc((u64)ParseMemo_Count * num_positions, sizeof(u32));
+        if (memo->slots == GS_NULL_PTR) return false;
+
+        memo->num_positions = num_positions;
+        memo->end_position = 0;
+        memo->entries = GS_NULL_PTR;
+        memo->num_entries = 0;
+        memo->capacity = 0;
+
         return true;
 }
 
+void __parser_MemoDeinit(ParserContext *context) {
+        ParseMemo *memo = &context->memo;
+        context->allocator.free(memo->entries);
+        context->allocator.free(memo->slots);
+
+        memo->slots = GS_NULL_PTR;
+        memo->num_positions = 0;
+        memo->end_position = 0;
+        memo->entries = GS_NULL_PTR;
+        memo->num_entries = 0;
+        memo->capacity = 0;
+}
+
+ParseMemoEntry *__parser_MemoAddEntry(ParserContext *context) {
+        ParseMemo *memo = &context->memo;
+        if (memo->num_entries == memo->capacity) {
+                u32 capacity = (memo->capacity == 0) ? 256 : memo->capacity * 2;
+                ParseMemoEntry *entries = context->allocator.realloc(memo->entries, sizeof(ParseMemoEntry) * capacity);
+                if (entries == GS_NULL_PTR) return GS_NULL_PTR;
+
+                memo->entries = entries;
+                memo->capacity = capacity;
+        }
+
+        return &memo->entries[memo->num_entries++];
+}
+
+/*
+  Runs `rule' through the memo table. Only token streams have a stable
+  position to key on, so on-demand tokenizers always parse directly.
+
+  An entry refers to the subtree the rule built rather than copying it. A
+  rule is only retried at a position after the alternative holding its
+  earlier result has been rolled back, so a nonempty successful subtree is
+  linked into the new node as it is. Failures and empty matches may still be
+  held by a live tree and are copied; both are a node or two.
+*/
+bool __parser_Memoized(ParserContext *context, ParseMemoRule memo_rule, bool (*rule)(ParserContext *, Tokenizer *, ParseTreeNode *), Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        ParseMemo *memo = &context->memo;
+        if (memo->slots == GS_NULL_PTR || tokenizer->tokens == GS_NULL_PTR) {
+                return rule(context, tokenizer, parse_tree);
+        }
+
+        u32 position = tokenizer->cursor;
+        u32 *slot = &memo->slots[memo_rule * memo->num_positions + position];
+        if (*slot != 0) {
+                ParseMemoEntry *entry = &memo->entries[*slot - 1];
+                if (entry->success && entry->end.cursor != position) {
+                        ParseTreeSet(parse_tree, entry->subtree.type, entry->subtree.token);
+                        gs_TreeShareChildren(&parse_tree->tree, &entry->subtree.tree);
+                } else {
+                        ParseTreeCopy(&context->tree, parse_tree, &entry->subtree);
+                }
+                if (entry->success) *tokenizer = entry->end;
+                return entry->success;
+        }
+
+        bool result = rule(context, tokenizer, parse_tree);
+
+        ParseMemoEntry *entry = __parser_MemoAddEntry(context);
+        if (entry == GS_NULL_PTR) return result;
+
+        entry->success = result;
+        entry->end = *tokenizer;
+        entry->subtree = *parse_tree;
+        entry->subtree.tree.sibling = GS_NULL_PTR;
+        *slot = memo->num_entries;
+        memo->end_position = gs_Max(memo->end_position, position + 1);
+
+        return result;
+}
+
+/*
+  Drops every entry. Slots before `position' are left set, so parsing must
+  not return there; the rest are cleared, which costs only as many positions
+  as were memoized past it.
+*/
+void __parser_MemoForget(ParserContext *context, u32 position) {
+        ParseMemo *memo = &context->memo;
+        for (u32 rule = 0; rule < ParseMemo_Count; rule++) {
+                u32 *slots = memo->slots + (u64)rule * memo->num_positions;
+                for (u32 i = position; i < memo->end_position; i++) slots[i] = 0;
+        }
+        memo->end_position = gs_Min(memo->end_position, position);
+        memo->num_entries = 0;
+}
+
+/*
+  A failed rule hands back everything it allocated by rolling the parse tree
+  arena back to where it stood on entry. Memo entries recorded since then
+  refer to nodes in that range, so those failures only detach the children.
+*/
+typedef struct ParseMark {
+        gs_ArenaMark arena;
+        u32 num_memo_entries;
+} ParseMark;
+
+ParseMark __parser_Mark(ParserContext *context) {
+        ParseMark mark = { .arena = ParseTreeGetMark(&context->tree), .num_memo_entries = context->memo.num_entries };
+        return mark;
+}
+
+void __parser_Rollback(ParserContext *context, ParseTreeNode *parse_tree, ParseMark mark) {
+        if (context->memo.num_entries != mark.num_memo_entries) {
+                ParseTreeRemoveAllChildren(&context->tree, parse_tree);
+                return;
+        }
+
+        ParseTreeRollback(&context->tree, parse_tree, mark.arena);
+}
+
+/*
+  Keyword classes used for predictive dispatch. Every keyword has its own
+  token type, so these are switches on an integer.
+*/
+bool __parser_IsStorageClassKeyword(TokenType type) {
+        switch (type) {
+                case Token_KeywordAuto:
+                case Token_KeywordRegister:
+                case Token_KeywordStatic:
+                case Token_KeywordExtern:
+                case Token_KeywordTypedef:
+                        return true;
+                default:
+                        return false;
+        }
+}
+
+bool __parser_IsTypeQualifierKeyword(TokenType type) {
+        return Token_KeywordConst == type || Token_KeywordVolatile == type;
+}
+
+bool __parser_IsBasicTypeKeyword(TokenType type) {
+        switch (type) {
+                case Token_KeywordVoid:
+                case Token_KeywordChar:
+                case Token_KeywordShort:
+                case Token_KeywordInt:
+                case Token_KeywordLong:
+                case Token_KeywordFloat:
+                case Token_KeywordDouble:
+                case Token_KeywordSigned:
+                case Token_KeywordUnsigned:
+                        return true;
+                default:
+                        return false;
+        }
+}
+
+/* Keywords that can begin a type-name. */
+bool __parser_IsTypeNameKeyword(TokenType type) {
+        return __parser_IsBasicTypeKeyword(type) ||
+               __parser_IsTypeQualifierKeyword(type) ||
+               Token_KeywordStruct == type ||
+               Token_KeywordUnion == type ||
+               Token_KeywordEnum == type;
+}
+
 /*
   constant:
   integer-constant
@@ -118,7 +406,8 @@ bool TypedefAddName(char *name) {
   floating-constant
   enumeration-constant
 */
-bool ParseConstant(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseConstant(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        (void)context;
         Tokenizer start = *tokenizer;
         Token token = GetToken(tokenizer);
 
@@ -139,24 +428,25 @@ bool ParseConstant(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         }
 }
 
-bool ParseArgumentExpressionListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseArgumentExpressionListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_ArgumentExpressionListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_Comma == (token = GetToken(tokenizer)).type &&
-            ParseAssignmentExpression(tokenizer, child2) &&
-            ParseArgumentExpressionListI(tokenizer, child3)) {
+            ParseAssignmentExpression(context, tokenizer, child2) &&
+            ParseArgumentExpressionListI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -167,20 +457,21 @@ bool ParseArgumentExpressionListI(Tokenizer *tokenizer, ParseTreeNode *parse_tre
   assignment-expression
   argument-expression-list , assignment-expression
 */
-bool ParseArgumentExpressionList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseArgumentExpressionList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_ArgumentExpressionList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseAssignmentExpression(tokenizer, child1) &&
-            ParseArgumentExpressionListI(tokenizer, child2)) {
+        if (ParseAssignmentExpression(context, tokenizer, child1) &&
+            ParseArgumentExpressionListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -193,164 +484,110 @@ bool ParseArgumentExpressionList(Tokenizer *tokenizer, ParseTreeNode *parse_tree
   string
   ( expression )
 */
-bool ParsePrimaryExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParsePrimaryExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[2];
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_PrimaryExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-
-        if (Token_Identifier == (tokens[0] = GetToken(tokenizer)).type) {
-                ParseTreeSet(child1, ParseTreeNode_Identifier, tokens[0]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseConstant(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_String == (tokens[0] = GetToken(tokenizer)).type) {
-                ParseTreeSet(child1, ParseTreeNode_String, tokens[0]);
-                return true;
-        }
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseExpression(tokenizer, child2) &&
-            Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
-                return true;
+        tokens[0] = PeekToken(tokenizer);
+        switch (tokens[0].type) {
+                case Token_Identifier: {
+                        GetToken(tokenizer);
+                        ParseTreeSet(child1, ParseTreeNode_Identifier, tokens[0]);
+                        return true;
+                } break;
+                case Token_Integer:
+                case Token_Character:
+                case Token_PrecisionNumber: {
+                        if (ParseConstant(context, tokenizer, child1)) return true;
+                } break;
+                case Token_String: {
+                        GetToken(tokenizer);
+                        ParseTreeSet(child1, ParseTreeNode_String, tokens[0]);
+                        return true;
+                } break;
+                case Token_OpenParen: {
+                        GetToken(tokenizer);
+                        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+                        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+
+                        if (ParseExpression(context, tokenizer, child2) &&
+                            Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type) {
+                                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
+                                ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
+                                return true;
+                        }
+                } break;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParsePostfixExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParsePostfixExpressionI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[2];
         ParseTreeNode *child1, *child2, *child3, *child4;
 
         parse_tree->type = ParseTreeNode_PostfixExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-
-        if (Token_OpenBracket == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseExpression(tokenizer, child2) &&
-            Token_CloseBracket == (tokens[0] = GetToken(tokenizer)).type &&
-            ParsePostfixExpressionI(tokenizer, child4)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
-                return true;
-        }
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseArgumentExpressionList(tokenizer, child2) &&
-            Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParsePostfixExpressionI(tokenizer, child4)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-            Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParsePostfixExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_Dot == (tokens[0] = GetToken(tokenizer)).type &&
-            Token_Identifier == (tokens[1] = GetToken(tokenizer)).type &&
-            ParsePostfixExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                ParseTreeSet(child2, ParseTreeNode_Identifier, tokens[1]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_Arrow == (tokens[0] = GetToken(tokenizer)).type &&
-            Token_Identifier == (tokens[1] = GetToken(tokenizer)).type &&
-            ParsePostfixExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                ParseTreeSet(child2, ParseTreeNode_Identifier, tokens[1]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_PlusPlus == (tokens[0] = GetToken(tokenizer)).type &&
-            ParsePostfixExpressionI(tokenizer, child2)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_MinusMinus == (tokens[0] = GetToken(tokenizer)).type &&
-            ParsePostfixExpressionI(tokenizer, child2)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                return true;
+        tokens[0] = GetToken(tokenizer);
+        switch (tokens[0].type) {
+                case Token_OpenBracket: {
+                        if (ParseExpression(context, tokenizer, child2) &&
+                            Token_CloseBracket == (tokens[1] = GetToken(tokenizer)).type &&
+                            ParsePostfixExpressionI(context, tokenizer, child4)) {
+                                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
+                                ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
+                                return true;
+                        }
+                } break;
+                case Token_OpenParen: {
+                        if (Token_CloseParen == PeekToken(tokenizer).type) {
+                                tokens[1] = GetToken(tokenizer);
+                                if (ParsePostfixExpressionI(context, tokenizer, child3)) {
+                                        ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
+                                        ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
+                                        return true;
+                                }
+                        } else if (ParseArgumentExpressionList(context, tokenizer, child2) &&
+                                   Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
+                                   ParsePostfixExpressionI(context, tokenizer, child4)) {
+                                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
+                                ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
+                                return true;
+                        }
+                } break;
+                case Token_Dot:
+                case Token_Arrow: {
+                        if (Token_Identifier == (tokens[1] = GetToken(tokenizer)).type &&
+                            ParsePostfixExpressionI(context, tokenizer, child3)) {
+                                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
+                                ParseTreeSet(child2, ParseTreeNode_Identifier, tokens[1]);
+                                return true;
+                        }
+                } break;
+                case Token_PlusPlus:
+                case Token_MinusMinus: {
+                        if (ParsePostfixExpressionI(context, tokenizer, child2)) {
+                                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
+                                return true;
+                        }
+                } break;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -366,26 +603,28 @@ bool ParsePostfixExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   postfix-expression ++
   postfix-expression --
 */
-bool ParsePostfixExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParsePostfixExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_PostfixExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParsePrimaryExpression(tokenizer, child1) &&
-            ParsePostfixExpressionI(tokenizer, child2)) {
+        if (ParsePrimaryExpression(context, tokenizer, child1) &&
+            ParsePostfixExpressionI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseUnaryOperator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseUnaryOperator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        (void)context;
         Tokenizer start = *tokenizer;
         Token token = GetToken(tokenizer);
         switch (token.type) {
@@ -416,624 +655,305 @@ bool ParseUnaryOperator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   sizeof unary-expression
   sizeof ( type-name )
 */
-bool ParseUnaryExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool __parser_ParseUnaryExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[2];
         ParseTreeNode *child1, *child2, *child3, *child4;
 
         parse_tree->type = ParseTreeNode_UnaryExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-
-        if (ParsePostfixExpression(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_PlusPlus == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseUnaryExpression(tokenizer, child2)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_MinusMinus == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseUnaryExpression(tokenizer, child2)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseUnaryOperator(tokenizer, child1) &&
-            ParseCastExpression(tokenizer, child2)) {
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        tokens[0] = GetToken(tokenizer);
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("sizeof", tokens[0].text, gs_StringLength("sizeof"))) {
-                ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-
-                Tokenizer Previous = *tokenizer;
-                if (ParseUnaryExpression(tokenizer, child2)) {
-                        return true;
-                }
-
-                *tokenizer = Previous;
-                if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-                    ParseTypeName(tokenizer, child3) &&
-                    Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type) {
-                        ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[0]);
-                        ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[1]);
-                        return true;
-                }
-        }
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-        return false;
-}
+        tokens[0] = PeekToken(tokenizer);
+        switch (tokens[0].type) {
+                case Token_PlusPlus:
+                case Token_MinusMinus: {
+                        GetToken(tokenizer);
+                        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-/*
-  cast-expression:
-  unary-expression
-  ( type-name ) cast-expression
-*/
-bool ParseCastExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token tokens[2];
-        ParseTreeNode *child1, *child2, *child3, *child4;
-
-        parse_tree->type = ParseTreeNode_CastExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-
-        if (ParseUnaryExpression(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseTypeName(tokenizer, child2) &&
-            Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseCastExpression(tokenizer, child4)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
-                ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-        return false;
-}
-
-bool ParseMultiplicativeExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token token;
-        ParseTreeNode *child1, *child2, *child3;
-
-        parse_tree->type = ParseTreeNode_MultiplicativeExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-
-        if (Token_Asterisk == (token = GetToken(tokenizer)).type &&
-            ParseCastExpression(tokenizer, child2) &&
-            ParseMultiplicativeExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_Slash == (token = GetToken(tokenizer)).type &&
-            ParseCastExpression(tokenizer, child2) &&
-            ParseMultiplicativeExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_PercentSign == (token = GetToken(tokenizer)).type &&
-            ParseCastExpression(tokenizer, child2) &&
-            ParseMultiplicativeExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return true;
-}
-
-/*
-  multiplicative-expression:
-  cast-expression
-  multiplicative-expression * cast-expression
-  multiplicative-expression / cast-expression
-  multiplicative-expression % cast-expression
-*/
-bool ParseMultiplicativeExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2;
-
-        parse_tree->type = ParseTreeNode_MultiplicativeExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-
-        if (ParseCastExpression(tokenizer, child1) &&
-            ParseMultiplicativeExpressionI(tokenizer, child2)) {
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return false;
-}
-
-bool ParseAdditiveExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token token;
-        ParseTreeNode *child1, *child2, *child3;
-
-        parse_tree->type = ParseTreeNode_AdditiveExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-
-        if (Token_Cross == (token = GetToken(tokenizer)).type &&
-            ParseMultiplicativeExpression(tokenizer, child2) &&
-            ParseAdditiveExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_Dash == (token = GetToken(tokenizer)).type &&
-            ParseMultiplicativeExpression(tokenizer, child2) &&
-            ParseAdditiveExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return true;
-}
-
-/*
-  additive-expression:
-  multiplicative-expression
-  additive-expression + multiplicative-expression
-  additive-expression - multiplicative-expression
-*/
-bool ParseAdditiveExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2;
-
-        parse_tree->type = ParseTreeNode_AdditiveExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-
-        if (ParseMultiplicativeExpression(tokenizer, child1) &&
-            ParseAdditiveExpressionI(tokenizer, child2)) {
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return false;
-}
-
-bool ParseShiftExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token token;
-        ParseTreeNode *child1, *child2, *child3;
-
-        parse_tree->type = ParseTreeNode_ShiftExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-
-        if (Token_BitShiftLeft == (token = GetToken(tokenizer)).type &&
-            ParseAdditiveExpression(tokenizer, child2) &&
-            ParseShiftExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_BitShiftRight == (token = GetToken(tokenizer)).type &&
-            ParseAdditiveExpression(tokenizer, child2) &&
-            ParseShiftExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return true;
-}
-
-/*
-  shift-expression:
-  additive-expression
-  shift-expression << additive-expression
-  shift-expression >> additive-expression
-*/
-bool ParseShiftExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2;
-
-        parse_tree->type = ParseTreeNode_ShiftExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-
-        if (ParseAdditiveExpression(tokenizer, child1) &&
-            ParseShiftExpressionI(tokenizer, child2)) {
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-        return false;
-}
-
-bool ParseRelationalExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token token;
-        ParseTreeNode *child1, *child2, *child3;
-
-        parse_tree->type = ParseTreeNode_RelationalExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-
-        if (Token_LessThan == (token = GetToken(tokenizer)).type &&
-            ParseShiftExpression(tokenizer, child2) &&
-            ParseRelationalExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_GreaterThan == (token = GetToken(tokenizer)).type &&
-            ParseShiftExpression(tokenizer, child2) &&
-            ParseRelationalExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_LessThanEqual == (token = GetToken(tokenizer)).type &&
-            ParseShiftExpression(tokenizer, child2) &&
-            ParseRelationalExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_GreaterThanEqual == (token = GetToken(tokenizer)).type &&
-            ParseShiftExpression(tokenizer, child2) &&
-            ParseRelationalExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return true;
-}
-
-/*
-  relational-expression:
-  shift-expression
-  relational-expression < shift-expression
-  relational-expression > shift-expression
-  relational-expression <= shift-exression
-  relational-expression >= shift-expression
-*/
-bool ParseRelationalExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2;
-
-        parse_tree->type = ParseTreeNode_RelationalExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-
-        if (ParseShiftExpression(tokenizer, child1) &&
-            ParseRelationalExpressionI(tokenizer, child2)) {
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return false;
-}
-
-bool ParseEqualityExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token token;
-        ParseTreeNode *child1, *child2, *child3;
-
-        parse_tree->type = ParseTreeNode_EqualityExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-
-        if (Token_LogicalEqual == (token = GetToken(tokenizer)).type &&
-            ParseRelationalExpression(tokenizer, child2) &&
-            ParseEqualityExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_NotEqual == (token = GetToken(tokenizer)).type &&
-            ParseRelationalExpression(tokenizer, child2) &&
-            ParseEqualityExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return true;
-}
-
-/*
-  equality-expression:
-  relational-expression
-  equality-expression == relational-expression
-  equality-expression != relational-expression
-*/
-bool ParseEqualityExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2;
+                        if (ParseUnaryExpression(context, tokenizer, child2)) {
+                                ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
+                                return true;
+                        }
+                } break;
+                case Token_Ampersand:
+                case Token_Asterisk:
+                case Token_Cross:
+                case Token_Dash:
+                case Token_Tilde:
+                case Token_Bang: {
+                        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        parse_tree->type = ParseTreeNode_EqualityExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+                        if (ParseUnaryOperator(context, tokenizer, child1) &&
+                            ParseCastExpression(context, tokenizer, child2)) {
+                                return true;
+                        }
+                } break;
+                case Token_KeywordSizeof: {
+                        GetToken(tokenizer);
+                        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+                        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+                        child4 = ParseTreeAddChild(&context->tree, parse_tree);
+                        ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
+
+                        /* sizeof (x) is ambiguous until x is known to be a type, so both forms are tried. */
+                        Tokenizer Previous = *tokenizer;
+                        if (ParseUnaryExpression(context, tokenizer, child2)) {
+                                return true;
+                        }
 
-        if (ParseRelationalExpression(tokenizer, child1) &&
-            ParseEqualityExpressionI(tokenizer, child2)) {
-                return true;
+                        *tokenizer = Previous;
+                        if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
+                            ParseTypeName(context, tokenizer, child3) &&
+                            Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type) {
+                                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[0]);
+                                ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[1]);
+                                return true;
+                        }
+                } break;
+                default: {
+                        if (ParsePostfixExpression(context, tokenizer, child1)) return true;
+                } break;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
-
         return false;
 }
 
-bool ParseAndExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token token;
-        ParseTreeNode *child1, *child2, *child3;
-
-        parse_tree->type = ParseTreeNode_AndExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-
-        if (Token_Ampersand == (token = GetToken(tokenizer)).type &&
-            ParseEqualityExpression(tokenizer, child2) &&
-            ParseAndExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return true;
+bool ParseUnaryExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return __parser_Memoized(context, ParseMemo_UnaryExpression, __parser_ParseUnaryExpression, tokenizer, parse_tree);
 }
 
 /*
-  AND-expression:
-  equality-expression
-  AND-expression & equality-expression
+  cast-expression:
+  unary-expression
+  ( type-name ) cast-expression
 */
-bool ParseAndExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool __parser_ParseCastExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2;
-
-        parse_tree->type = ParseTreeNode_AndExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        ParseMark mark = __parser_Mark(context);
+        Tokenizer lookahead = *tokenizer;
+        Token tokens[2];
+        ParseTreeNode *child1, *child2, *child3, *child4;
 
-        if (ParseEqualityExpression(tokenizer, child1) &&
-            ParseAndExpressionI(tokenizer, child2)) {
-                return true;
+        /*
+          A type keyword after the parenthesis can only begin a cast. A typedef
+          name may still turn out to be a parenthesized expression, so that case
+          falls back to unary-expression.
+        */
+        bool is_cast = false, may_be_cast = false;
+        if (Token_OpenParen == (tokens[0] = GetToken(&lookahead)).type) {
+                tokens[1] = GetToken(&lookahead);
+                is_cast = __parser_IsTypeNameKeyword(tokens[1].type);
+                may_be_cast = Token_Identifier == tokens[1].type && TypedefIsName(context, tokens[1]);
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
+        parse_tree->type = ParseTreeNode_CastExpression;
 
-        return false;
-}
+        if (is_cast || may_be_cast) {
+                child1 = ParseTreeAddChild(&context->tree, parse_tree);
+                child2 = ParseTreeAddChild(&context->tree, parse_tree);
+                child3 = ParseTreeAddChild(&context->tree, parse_tree);
+                child4 = ParseTreeAddChild(&context->tree, parse_tree);
 
-bool ParseExclusiveOrExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token token;
-        ParseTreeNode *child1, *child2, *child3;
+                if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
+                    ParseTypeName(context, tokenizer, child2) &&
+                    Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
+                    ParseCastExpression(context, tokenizer, child4)) {
+                        ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
+                        ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
+                        return true;
+                }
 
-        parse_tree->type = ParseTreeNode_ExclusiveOrExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+                __parser_Rollback(context, parse_tree, mark);
+                *tokenizer = start;
 
-        if (Token_Carat == (token = GetToken(tokenizer)).type &&
-            ParseAndExpression(tokenizer, child2) &&
-            ParseExclusiveOrExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
+                if (is_cast) return false;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return true;
-}
-
-/*
-  exclusive-OR-expression
-  AND-expression
-  exclusive-OR-expression ^ AND-expression
-*/
-bool ParseExclusiveOrExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2;
-
-        parse_tree->type = ParseTreeNode_ExclusiveOrExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseAndExpression(tokenizer, child1) &&
-            ParseExclusiveOrExpressionI(tokenizer, child2)) {
-                return true;
-        }
+        if (ParseUnaryExpression(context, tokenizer, child1)) return true;
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
-
         return false;
 }
 
-bool ParseInclusiveOrExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token token;
-        ParseTreeNode *child1, *child2, *child3;
+bool ParseCastExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return __parser_Memoized(context, ParseMemo_CastExpression, __parser_ParseCastExpression, tokenizer, parse_tree);
+}
+
+/*
+  Binding power of each binary operator, loosest first. Every level is left
+  associative.
+*/
+typedef enum BinaryPrecedence {
+        BinaryPrecedence_None,
+        BinaryPrecedence_LogicalOr,
+        BinaryPrecedence_LogicalAnd,
+        BinaryPrecedence_InclusiveOr,
+        BinaryPrecedence_ExclusiveOr,
+        BinaryPrecedence_And,
+        BinaryPrecedence_Equality,
+        BinaryPrecedence_Relational,
+        BinaryPrecedence_Shift,
+        BinaryPrecedence_Additive,
+        BinaryPrecedence_Multiplicative,
+} BinaryPrecedence;
+
+typedef struct BinaryOperator {
+        BinaryPrecedence precedence;
+        ParseTreeNodeType type;
+} BinaryOperator;
+
+static BinaryOperator __parser_binary_operators[] = {
+        [Token_Asterisk]         = { BinaryPrecedence_Multiplicative, ParseTreeNode_MultiplicativeExpression },
+        [Token_Slash]            = { BinaryPrecedence_Multiplicative, ParseTreeNode_MultiplicativeExpression },
+        [Token_PercentSign]      = { BinaryPrecedence_Multiplicative, ParseTreeNode_MultiplicativeExpression },
+        [Token_Cross]            = { BinaryPrecedence_Additive,       ParseTreeNode_AdditiveExpression },
+        [Token_Dash]             = { BinaryPrecedence_Additive,       ParseTreeNode_AdditiveExpression },
+        [Token_BitShiftLeft]     = { BinaryPrecedence_Shift,          ParseTreeNode_ShiftExpression },
+        [Token_BitShiftRight]    = { BinaryPrecedence_Shift,          ParseTreeNode_ShiftExpression },
+        [Token_LessThan]         = { BinaryPrecedence_Relational,     ParseTreeNode_RelationalExpression },
+        [Token_GreaterThan]      = { BinaryPrecedence_Relational,     ParseTreeNode_RelationalExpression },
+        [Token_LessThanEqual]    = { BinaryPrecedence_Relational,     ParseTreeNode_RelationalExpression },
+        [Token_GreaterThanEqual] = { BinaryPrecedence_Relational,     ParseTreeNode_RelationalExpression },
+        [Token_LogicalEqual]     = { BinaryPrecedence_Equality,       ParseTreeNode_EqualityExpression },
+        [Token_NotEqual]         = { BinaryPrecedence_Equality,       ParseTreeNode_EqualityExpression },
+        [Token_Ampersand]        = { BinaryPrecedence_And,            ParseTreeNode_AndExpression },
+        [Token_Carat]            = { BinaryPrecedence_ExclusiveOr,    ParseTreeNode_ExclusiveOrExpression },
+        [Token_Pipe]             = { BinaryPrecedence_InclusiveOr,    ParseTreeNode_InclusiveOrExpression },
+        [Token_LogicalAnd]       = { BinaryPrecedence_LogicalAnd,     ParseTreeNode_LogicalAndExpression },
+        [Token_LogicalOr]        = { BinaryPrecedence_LogicalOr,      ParseTreeNode_LogicalOrExpression },
+};
+
+BinaryOperator __parser_BinaryOperator(TokenType type) {
+        if (type >= gs_ArraySize(__parser_binary_operators)) {
+                BinaryOperator none = { BinaryPrecedence_None, ParseTreeNode_Unknown };
+                return none;
+        }
+        return __parser_binary_operators[type];
+}
+
+/*
+  Precedence climbing over cast-expression operands, covering every binary
+  level from multiplicative-expression up to logical-OR-expression.
+  Each operator becomes one node of its level's type holding the operator
+  token, with the left and right operands as its two children. An operand
+  with no operator after it is written straight into parse_tree, so a bare
+  operand doesn't pay for a node per level.
+*/
+bool ParseBinaryExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree, BinaryPrecedence min_precedence) {
+        Tokenizer start = *tokenizer;
+
+        if (!ParseCastExpression(context, tokenizer, parse_tree)) {
+                *tokenizer = start;
+                return false;
+        }
 
-        parse_tree->type = ParseTreeNode_InclusiveOrExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        while (true) {
+                Tokenizer at_operator = *tokenizer;
+                Token token = GetToken(tokenizer);
+                BinaryOperator operator = __parser_BinaryOperator(token.type);
 
-        if (Token_Pipe == (token = GetToken(tokenizer)).type &&
-            ParseExclusiveOrExpression(tokenizer, child2) &&
-            ParseInclusiveOrExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
+                if (BinaryPrecedence_None == operator.precedence || operator.precedence < min_precedence) {
+                        *tokenizer = at_operator;
+                        return true;
+                }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
+                ParseTreePushDown(&context->tree, parse_tree);
+                ParseTreeSet(parse_tree, operator.type, token);
+                ParseTreeNode *rhs = ParseTreeAddChild(&context->tree, parse_tree);
 
-        return true;
+                if (!ParseBinaryExpression(context, tokenizer, rhs, operator.precedence + 1)) {
+                        /* As with the grammar's optional tails, an operator without a right operand isn't consumed. */
+                        ParseTreePullUp(&context->tree, parse_tree);
+                        *tokenizer = at_operator;
+                        return true;
+                }
+        }
 }
 
 /*
-  inclusive-OR-expression:
-  exclusive-OR-expression
-  inclusive-OR-expression | exclusive-OR-expression
+  multiplicative-expression:
+  cast-expression
+  multiplicative-expression * cast-expression
+  multiplicative-expression / cast-expression
+  multiplicative-expression % cast-expression
 */
-bool ParseInclusiveOrExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2;
-
-        parse_tree->type = ParseTreeNode_InclusiveOrExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-
-        if (ParseExclusiveOrExpression(tokenizer, child1) &&
-            ParseInclusiveOrExpressionI(tokenizer, child2)) {
-                return true;
-        }
+bool ParseMultiplicativeExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return ParseBinaryExpression(context, tokenizer, parse_tree, BinaryPrecedence_Multiplicative);
+}
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
+/*
+  additive-expression:
+  multiplicative-expression
+  additive-expression + multiplicative-expression
+  additive-expression - multiplicative-expression
+*/
+bool ParseAdditiveExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return ParseBinaryExpression(context, tokenizer, parse_tree, BinaryPrecedence_Additive);
+}
 
-        return false;
+/*
+  shift-expression:
+  additive-expression
+  shift-expression << additive-expression
+  shift-expression >> additive-expression
+*/
+bool ParseShiftExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return ParseBinaryExpression(context, tokenizer, parse_tree, BinaryPrecedence_Shift);
 }
 
-bool ParseLogicalAndExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token token;
-        ParseTreeNode *child1, *child2, *child3;
+/*
+  relational-expression:
+  shift-expression
+  relational-expression < shift-expression
+  relational-expression > shift-expression
+  relational-expression <= shift-expression
+  relational-expression >= shift-expression
+*/
+bool ParseRelationalExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return ParseBinaryExpression(context, tokenizer, parse_tree, BinaryPrecedence_Relational);
+}
 
-        parse_tree->type = ParseTreeNode_LogicalAndExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+/*
+  equality-expression:
+  relational-expression
+  equality-expression == relational-expression
+  equality-expression != relational-expression
+*/
+bool ParseEqualityExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return ParseBinaryExpression(context, tokenizer, parse_tree, BinaryPrecedence_Equality);
+}
 
-        if (Token_LogicalAnd == (token = GetToken(tokenizer)).type &&
-            ParseInclusiveOrExpression(tokenizer, child2) &&
-            ParseLogicalAndExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
+/*
+  AND-expression:
+  equality-expression
+  AND-expression & equality-expression
+*/
+bool ParseAndExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return ParseBinaryExpression(context, tokenizer, parse_tree, BinaryPrecedence_And);
+}
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
+/*
+  exclusive-OR-expression:
+  AND-expression
+  exclusive-OR-expression ^ AND-expression
+*/
+bool ParseExclusiveOrExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return ParseBinaryExpression(context, tokenizer, parse_tree, BinaryPrecedence_ExclusiveOr);
+}
 
-        return true;
+/*
+  inclusive-OR-expression:
+  exclusive-OR-expression
+  inclusive-OR-expression | exclusive-OR-expression
+*/
+bool ParseInclusiveOrExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return ParseBinaryExpression(context, tokenizer, parse_tree, BinaryPrecedence_InclusiveOr);
 }
 
 /*
@@ -1041,46 +961,8 @@ bool ParseLogicalAndExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree)
   inclusive-OR-expression
   logical-AND-expression && inclusive-OR-expression
 */
-bool ParseLogicalAndExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2;
-
-        parse_tree->type = ParseTreeNode_LogicalAndExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-
-        if (ParseInclusiveOrExpression(tokenizer, child1) &&
-            ParseLogicalAndExpressionI(tokenizer, child2)) {
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return false;
-}
-
-bool ParseLogicalOrExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        Token token;
-        ParseTreeNode *child1, *child2, *child3;
-
-        parse_tree->type = ParseTreeNode_LogicalOrExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-
-        if (Token_LogicalOr == (token = GetToken(tokenizer)).type &&
-            ParseLogicalAndExpression(tokenizer, child2) &&
-            ParseLogicalOrExpressionI(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return true;
+bool ParseLogicalAndExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return ParseBinaryExpression(context, tokenizer, parse_tree, BinaryPrecedence_LogicalAnd);
 }
 
 /*
@@ -1088,41 +970,31 @@ bool ParseLogicalOrExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree)
   logical-AND-expression
   logical-OR-expression || logical-AND-expression
 */
-bool ParseLogicalOrExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2;
-
-        parse_tree->type = ParseTreeNode_LogicalOrExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-
-        if (ParseLogicalAndExpression(tokenizer, child1) &&
-            ParseLogicalOrExpressionI(tokenizer, child2)) {
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
+bool __parser_ParseLogicalOrExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return ParseBinaryExpression(context, tokenizer, parse_tree, BinaryPrecedence_LogicalOr);
+}
 
-        return false;
+bool ParseLogicalOrExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return __parser_Memoized(context, ParseMemo_LogicalOrExpression, __parser_ParseLogicalOrExpression, tokenizer, parse_tree);
 }
 
 /*
   constant-expression:
   conditional-expression
 */
-bool ParseConstantExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseConstantExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1;
 
         parse_tree->type = ParseTreeNode_ConstantExpression;
-        child1 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseConditionalExpression(tokenizer, child1)) {
+        if (ParseConditionalExpression(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -1133,47 +1005,49 @@ bool ParseConstantExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   logical-OR-expression
   logical-OR-expression ? expression : conditional-expression
 */
-bool ParseConditionalExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseConditionalExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
         Token tokens[2];
-        ParseTreeNode *child1, *child2, *child3, *child4, *child5;
+        ParseTreeNode *child2, *child3, *child4, *child5;
 
-        parse_tree->type = ParseTreeNode_ConditionalExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        child5 = ParseTreeAddChild(parse_tree);
-
-        if (ParseLogicalOrExpression(tokenizer, child1) &&
-            Token_QuestionMark == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseExpression(tokenizer, child3) &&
-            Token_Colon == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseConditionalExpression(tokenizer, child5)) {
-                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[0]);
-                ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[1]);
+        if (!ParseLogicalOrExpression(context, tokenizer, parse_tree)) {
+                *tokenizer = start;
+                return false;
+        }
+
+        Tokenizer at_question_mark = *tokenizer;
+        if (Token_QuestionMark != (tokens[0] = GetToken(tokenizer)).type) {
+                *tokenizer = at_question_mark;
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
+        ParseTreePushDown(&context->tree, parse_tree);
+        parse_tree->type = ParseTreeNode_ConditionalExpression;
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
+        child5 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseLogicalOrExpression(tokenizer, child1)) {
+        if (ParseExpression(context, tokenizer, child3) &&
+            Token_Colon == (tokens[1] = GetToken(tokenizer)).type &&
+            ParseConditionalExpression(context, tokenizer, child5)) {
+                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[0]);
+                ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
+        ParseTreePullUp(&context->tree, parse_tree);
+        *tokenizer = at_question_mark;
 
-        return false;
+        return true;
 }
 
 /*
   assignment-operator:
   one of: = *= /= %= += -= <<= >>= &= ^= |=
 */
-bool ParseAssignmentOperator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseAssignmentOperator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        (void)context;
         Tokenizer start = *tokenizer;
         Token token = GetToken(tokenizer);
 
@@ -1204,53 +1078,59 @@ bool ParseAssignmentOperator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   conditional-expression
   unary-expression assignment-operator assignment-expression
 */
-bool ParseAssignmentExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool __parser_ParseAssignmentExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_AssignmentExpression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseUnaryExpression(tokenizer, child1) &&
-            ParseAssignmentOperator(tokenizer, child2) &&
-            ParseAssignmentExpression(tokenizer, child3)) {
+        if (ParseUnaryExpression(context, tokenizer, child1) &&
+            ParseAssignmentOperator(context, tokenizer, child2) &&
+            ParseAssignmentExpression(context, tokenizer, child3)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseConditionalExpression(tokenizer, child1)) {
+        if (ParseConditionalExpression(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseAssignmentExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return __parser_Memoized(context, ParseMemo_AssignmentExpression, __parser_ParseAssignmentExpression, tokenizer, parse_tree);
+}
+
+bool ParseExpressionI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_ExpressionI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_Comma == (token = GetToken(tokenizer)).type &&
-            ParseAssignmentExpression(tokenizer, child2) &&
-            ParseExpressionI(tokenizer, child3)) {
+            ParseAssignmentExpression(context, tokenizer, child2) &&
+            ParseExpressionI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -1261,26 +1141,28 @@ bool ParseExpressionI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   assignment-expression
   expression , assignment-expression
 */
-bool ParseExpression(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseExpression(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_Expression;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseAssignmentExpression(tokenizer, child1) &&
-            ParseExpressionI(tokenizer, child2)) {
+        if (ParseAssignmentExpression(context, tokenizer, child1) &&
+            ParseExpressionI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseIdentifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseIdentifier(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        (void)context;
         Tokenizer start = *tokenizer;
         Token token;
 
@@ -1300,71 +1182,42 @@ bool ParseIdentifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   break ;
   return expression(opt) ;
 */
-bool ParseJumpStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseJumpStatement(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[2];
         tokens[0] = GetToken(tokenizer);
-        Tokenizer at_token = *tokenizer;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_JumpStatement;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("goto", tokens[0].text, tokens[0].text_length) &&
-            ParseIdentifier(tokenizer, child2) &&
-            Token_SemiColon == (tokens[1] = GetToken(tokenizer)).type) {
-                ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-                ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = at_token;
-
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("continue", tokens[0].text, tokens[0].text_length) &&
-            Token_SemiColon == (tokens[1] = GetToken(tokenizer)).type) {
-                ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = at_token;
-
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("break", tokens[0].text, tokens[0].text_length) &&
-            Token_SemiColon == (tokens[1] = GetToken(tokenizer)).type) {
-                ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = at_token;
-
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("return", tokens[0].text, tokens[0].text_length)) {
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+
+        if (Token_KeywordGoto == tokens[0].type) {
+                if (ParseIdentifier(context, tokenizer, child2) &&
+                    Token_SemiColon == (tokens[1] = GetToken(tokenizer)).type) {
+                        ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
+                        ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
+                        return true;
+                }
+        } else if (Token_KeywordContinue == tokens[0].type ||
+                   Token_KeywordBreak == tokens[0].type) {
+                if (Token_SemiColon == (tokens[1] = GetToken(tokenizer)).type) {
+                        ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
+                        ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
+                        return true;
+                }
+        } else if (Token_KeywordReturn == tokens[0].type) {
                 ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-                int ChildIndex = 1;
-                Tokenizer Previous = *tokenizer;
-
                 ParseTreeNode *child = child3;
-                if (!ParseExpression(tokenizer, child2)) {
+
+                if (Token_SemiColon == PeekToken(tokenizer).type) {
                         child = child2;
-                        *tokenizer = Previous;
+                } else if (!ParseExpression(context, tokenizer, child2)) {
+                        __parser_Rollback(context, parse_tree, mark);
+                        *tokenizer = start;
+                        return false;
                 }
 
                 if (Token_SemiColon == (tokens[1] = GetToken(tokenizer)).type) {
@@ -1373,7 +1226,7 @@ bool ParseJumpStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
                 }
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -1385,138 +1238,84 @@ bool ParseJumpStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   do statement while ( expression) ;
   for ( expression(opt) ; expression(opt) ; expression(opt) ) statement
 */
-bool ParseIterationStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseIterationStatement(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[5];
         tokens[0] = GetToken(tokenizer);
-        Tokenizer at_token = *tokenizer;
-        ParseTreeNode *child1, *child2, *child3, *child4, *child5;
+        ParseTreeNode *children[9];
 
         parse_tree->type = ParseTreeNode_IterationStatement;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        child5 = ParseTreeAddChild(parse_tree);
-
-        /* TODO(AARON): Not sure how many child nodes to create! */
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("while", tokens[0].text, tokens[0].text_length) &&
-            Token_OpenParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseExpression(tokenizer, child3) &&
-            Token_CloseParen == (tokens[2] = GetToken(tokenizer)).type &&
-            ParseStatement(tokenizer, child5)) {
-                ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
-                ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[2]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        child5 = ParseTreeAddChild(parse_tree);
-
-        /* TODO(AARON): Not sure how many child nodes to create! */
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-
-        *tokenizer = at_token;
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("do", tokens[0].text, tokens[0].text_length) &&
-            ParseStatement(tokenizer, child2)) {
-                ParseTreeNode *child_node = child1;
-                ParseTreeSet(child_node, ParseTreeNode_Keyword, tokens[0]);
-
-                tokens[1] = GetToken(tokenizer);
-                if (Token_Keyword == tokens[1].type &&
-                    gs_StringIsEqual("while", tokens[1].text, tokens[1].text_length) &&
+        for (int i = 0; i < gs_ArraySize(children); i++) {
+                children[i] = ParseTreeAddChild(&context->tree, parse_tree);
+        }
+
+        if (Token_KeywordWhile == tokens[0].type) {
+                if (Token_OpenParen == (tokens[1] = GetToken(tokenizer)).type &&
+                    ParseExpression(context, tokenizer, children[2]) &&
+                    Token_CloseParen == (tokens[2] = GetToken(tokenizer)).type &&
+                    ParseStatement(context, tokenizer, children[4])) {
+                        ParseTreeSet(children[0], ParseTreeNode_Keyword, tokens[0]);
+                        ParseTreeSet(children[1], ParseTreeNode_Symbol, tokens[1]);
+                        ParseTreeSet(children[3], ParseTreeNode_Symbol, tokens[2]);
+                        return true;
+                }
+        } else if (Token_KeywordDo == tokens[0].type) {
+                if (ParseStatement(context, tokenizer, children[1]) &&
+                    Token_KeywordWhile == (tokens[1] = GetToken(tokenizer)).type &&
                     Token_OpenParen == (tokens[2] = GetToken(tokenizer)).type &&
-                    ParseExpression(tokenizer, child5) &&
+                    ParseExpression(context, tokenizer, children[4]) &&
                     Token_CloseParen == (tokens[3] = GetToken(tokenizer)).type &&
                     Token_SemiColon == (tokens[4] = GetToken(tokenizer)).type) {
-                        ParseTreeSet(++child_node, ParseTreeNode_Keyword, tokens[1]);
-                        ParseTreeSet(++child_node, ParseTreeNode_Symbol, tokens[2]);
-                        ++child_node; // Child #4 is set in the `if' above.
-                        ParseTreeSet(++child_node, ParseTreeNode_Symbol, tokens[3]);
-                        ParseTreeSet(++child_node, ParseTreeNode_Symbol, tokens[4]);
+                        ParseTreeSet(children[0], ParseTreeNode_Keyword, tokens[0]);
+                        ParseTreeSet(children[2], ParseTreeNode_Keyword, tokens[1]);
+                        ParseTreeSet(children[3], ParseTreeNode_Symbol, tokens[2]);
+                        ParseTreeSet(children[5], ParseTreeNode_Symbol, tokens[3]);
+                        ParseTreeSet(children[6], ParseTreeNode_Symbol, tokens[4]);
                         return true;
                 }
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        child5 = ParseTreeAddChild(parse_tree);
-
-        /* TODO(AARON): Not sure how many child nodes to create! */
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-        ParseTreeAddChild(parse_tree);
-        *tokenizer = at_token;
-
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("for", tokens[0].text, tokens[0].text_length) &&
-            Token_OpenParen == (tokens[1] = GetToken(tokenizer)).type) {
-                ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
+        } else if (Token_KeywordFor == tokens[0].type &&
+                   Token_OpenParen == (tokens[1] = GetToken(tokenizer)).type) {
+                ParseTreeSet(children[0], ParseTreeNode_Keyword, tokens[0]);
+                ParseTreeSet(children[1], ParseTreeNode_Symbol, tokens[1]);
 
                 int i = 2;
 
                 Tokenizer Previous = *tokenizer;
-                if (!ParseExpression(tokenizer, gs_TreeChildAt(parse_tree, ParseTreeNode, tree, i))) {
+                if (!ParseExpression(context, tokenizer, children[i])) {
                         *tokenizer = Previous;
                 } else {
                         i++;
                 }
 
-                if (Token_SemiColon != (tokens[2] = GetToken(tokenizer)).type) {
-                        *tokenizer = start;
-                        return false;
-                }
-                ParseTreeSet(gs_TreeChildAt(parse_tree, ParseTreeNode, tree, i++), ParseTreeNode_Symbol, tokens[2]);
+                if (Token_SemiColon == (tokens[2] = GetToken(tokenizer)).type) {
+                        ParseTreeSet(children[i++], ParseTreeNode_Symbol, tokens[2]);
 
-                Previous = *tokenizer;
-                if (!ParseExpression(tokenizer, gs_TreeChildAt(parse_tree, ParseTreeNode, tree, i++))) {
-                        --i;
-                        *tokenizer = Previous;
-                }
+                        Previous = *tokenizer;
+                        if (!ParseExpression(context, tokenizer, children[i++])) {
+                                --i;
+                                *tokenizer = Previous;
+                        }
 
-                if (Token_SemiColon != (tokens[3] = GetToken(tokenizer)).type) {
-                        *tokenizer = start;
-                        return false;
-                }
-                ParseTreeSet(gs_TreeChildAt(parse_tree, ParseTreeNode, tree, i++), ParseTreeNode_Symbol, tokens[3]);
+                        if (Token_SemiColon == (tokens[3] = GetToken(tokenizer)).type) {
+                                ParseTreeSet(children[i++], ParseTreeNode_Symbol, tokens[3]);
 
-                Previous = *tokenizer;
-                if (!ParseExpression(tokenizer, gs_TreeChildAt(parse_tree, ParseTreeNode, tree, i++))) {
-                        --i;
-                        *tokenizer = Previous;
-                }
+                                Previous = *tokenizer;
+                                if (!ParseExpression(context, tokenizer, children[i++])) {
+                                        --i;
+                                        *tokenizer = Previous;
+                                }
 
-                if (Token_CloseParen == (tokens[4] = GetToken(tokenizer)).type &&
-                    ParseStatement(tokenizer, gs_TreeChildAt(parse_tree, ParseTreeNode, tree, i + 1))) {
-                        ParseTreeSet(gs_TreeChildAt(parse_tree, ParseTreeNode, tree, i), ParseTreeNode_Symbol, tokens[4]);
-                        return true;
+                                if (Token_CloseParen == (tokens[4] = GetToken(tokenizer)).type &&
+                                    ParseStatement(context, tokenizer, children[i + 1])) {
+                                        ParseTreeSet(children[i], ParseTreeNode_Symbol, tokens[4]);
+                                        return true;
+                                }
+                        }
                 }
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -1528,86 +1327,75 @@ bool ParseIterationStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   if ( expression ) statement else statement
   switch ( expression ) statement
 */
-bool ParseSelectionStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseSelectionStatement(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[3];
         tokens[0] = GetToken(tokenizer);
-        Tokenizer at_token = *tokenizer;
         ParseTreeNode *child1, *child2, *child3, *child4, *child5, *child6;
 
         parse_tree->type = ParseTreeNode_SelectionStatement;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        child5 = ParseTreeAddChild(parse_tree);
-        child6 = ParseTreeAddChild(parse_tree);
-
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("if", tokens[0].text, tokens[0].text_length) &&
-            Token_OpenParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseExpression(tokenizer, child3) &&
-            Token_CloseParen == (tokens[2] = GetToken(tokenizer)).type &&
-            ParseStatement(tokenizer, child5)) {
-                Tokenizer at_else = *tokenizer;
-                Token token = GetToken(tokenizer);
-
-                ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
-                ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[2]);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
+        child5 = ParseTreeAddChild(&context->tree, parse_tree);
+        child6 = ParseTreeAddChild(&context->tree, parse_tree);
+
+        if (Token_KeywordIf == tokens[0].type) {
+                if (Token_OpenParen == (tokens[1] = GetToken(tokenizer)).type &&
+                    ParseExpression(context, tokenizer, child3) &&
+                    Token_CloseParen == (tokens[2] = GetToken(tokenizer)).type &&
+                    ParseStatement(context, tokenizer, child5)) {
+                        Tokenizer at_else = *tokenizer;
+                        Token token = GetToken(tokenizer);
+
+                        ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
+                        ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
+                        ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[2]);
+
+                        if (Token_KeywordElse == token.type &&
+                            ParseStatement(context, tokenizer, child6)) {
+                                ParseTreeSet(child5, ParseTreeNode_Keyword, token);
+                                return true;
+                        }
 
-                if (Token_Keyword == token.type &&
-                    gs_StringIsEqual("else", token.text, token.text_length) &&
-                    ParseStatement(tokenizer, child6)) {
-                        ParseTreeSet(child5, ParseTreeNode_Keyword, token);
+                        *tokenizer = at_else;
+                        return true;
+                }
+        } else if (Token_KeywordSwitch == tokens[0].type) {
+                if (Token_OpenParen == (tokens[1] = GetToken(tokenizer)).type &&
+                    ParseExpression(context, tokenizer, child3) &&
+                    Token_CloseParen == (tokens[2] = GetToken(tokenizer)).type &&
+                    ParseStatement(context, tokenizer, child5)) {
+                        ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
+                        ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
+                        ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[2]);
                         return true;
                 }
-
-                *tokenizer = at_else;
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        child5 = ParseTreeAddChild(parse_tree);
-        child6 = ParseTreeAddChild(parse_tree);
-        *tokenizer = at_token;
-
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("switch", tokens[0].text, tokens[0].text_length) &&
-            Token_OpenParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseExpression(tokenizer, child3) &&
-            Token_CloseParen == (tokens[2] = GetToken(tokenizer)).type &&
-            ParseStatement(tokenizer, child5)) {
-                ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
-                ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[2]);
-                return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseStatementListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStatementListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_StatementListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseStatement(tokenizer, child1) &&
-            ParseStatementListI(tokenizer, child2)) {
+        if (ParseStatement(context, tokenizer, child1) &&
+            ParseStatementListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -1618,20 +1406,21 @@ bool ParseStatementListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   statement
   statement-list statement
 */
-bool ParseStatementList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStatementList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_StatementList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseStatement(tokenizer, child1) &&
-            ParseStatementListI(tokenizer, child2)) {
+        if (ParseStatement(context, tokenizer, child1) &&
+            ParseStatementListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -1640,41 +1429,41 @@ bool ParseStatementList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
 /*
   compound-statement:
   { declaration-list(opt) statement-list(opt) }
-  TODO: AARON: Walking children this way is not good
 */
-bool ParseCompoundStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseCompoundStatement(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
-        ParseTreeNode *child1, *child2, *child3;
+        ParseTreeNode *child1, *child2, *child3, *child4;
 
         parse_tree->type = ParseTreeNode_CompoundStatement;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_OpenBrace == (token = GetToken(tokenizer)).type) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, token);
-                int i = 0;
 
-                Tokenizer Previous = *tokenizer;
-                if (!ParseDeclarationList(tokenizer, gs_TreeChildAt(parse_tree, ParseTreeNode, tree, i++))) {
-                        --i;
-                        *tokenizer = Previous;
+                Tokenizer previous = *tokenizer;
+                if (!ParseDeclarationList(context, tokenizer, child2)) {
+                        child2->type = ParseTreeNode_Unknown;
+                        *tokenizer = previous;
                 }
 
-                Previous = *tokenizer;
-                if (!ParseStatementList(tokenizer, gs_TreeChildAt(parse_tree, ParseTreeNode, tree, i++))) {
-                        --i;
-                        *tokenizer = Previous;
+                previous = *tokenizer;
+                if (!ParseStatementList(context, tokenizer, child3)) {
+                        child3->type = ParseTreeNode_Unknown;
+                        *tokenizer = previous;
                 }
 
                 if (Token_CloseBrace == (token = GetToken(tokenizer)).type) {
-                        ParseTreeSet(gs_TreeChildAt(parse_tree, ParseTreeNode, tree, i), ParseTreeNode_Symbol, token);
+                        ParseTreeSet(child4, ParseTreeNode_Symbol, token);
                         return true;
                 }
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -1684,32 +1473,29 @@ bool ParseCompoundStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   expression-statement:
   expression(opt) ;
 */
-bool ParseExpressionStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseExpressionStatement(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_ExpressionStatement;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseExpression(tokenizer, child1) &&
-            Token_SemiColon == (token = GetToken(tokenizer)).type) {
-                ParseTreeSet(child2, ParseTreeNode_Symbol, token);
+        if (Token_SemiColon == PeekToken(tokenizer).type) {
+                token = GetToken(tokenizer);
+                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (Token_SemiColon == (token = GetToken(tokenizer)).type) {
-                ParseTreeSet(child1, ParseTreeNode_Symbol, token);
+        if (ParseExpression(context, tokenizer, child1) &&
+            Token_SemiColon == (token = GetToken(tokenizer)).type) {
+                ParseTreeSet(child2, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -1721,61 +1507,46 @@ bool ParseExpressionStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   case constant-expression : statement
   default : statement
 */
-bool ParseLabeledStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseLabeledStatement(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[2];
         ParseTreeNode *child1, *child2, *child3, *child4;
 
         parse_tree->type = ParseTreeNode_LabeledStatement;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-
-        if (ParseIdentifier(tokenizer, child1) &&
-            Token_Colon == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseStatement(tokenizer, child3)) {
-                ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[0]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        tokens[0] = GetToken(tokenizer);
-        Tokenizer at_token = *tokenizer;
-
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("case", tokens[0].text, tokens[0].text_length) &&
-            ParseConstantExpression(tokenizer, child2) &&
-            Token_Colon == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseStatement(tokenizer, child4)) {
-                ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-                ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        *tokenizer = at_token;
-
-        if (Token_Keyword == tokens[0].type &&
-            gs_StringIsEqual("default", tokens[0].text, tokens[0].text_length) &&
-            Token_Colon == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseStatement(tokenizer, child3)) {
-                ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
-                ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
-                return true;
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
+
+        tokens[0] = PeekToken(tokenizer);
+        if (Token_Identifier == tokens[0].type) {
+                if (ParseIdentifier(context, tokenizer, child1) &&
+                    Token_Colon == (tokens[0] = GetToken(tokenizer)).type &&
+                    ParseStatement(context, tokenizer, child3)) {
+                        ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[0]);
+                        return true;
+                }
+        } else if (Token_KeywordCase == tokens[0].type) {
+                GetToken(tokenizer);
+                if (ParseConstantExpression(context, tokenizer, child2) &&
+                    Token_Colon == (tokens[1] = GetToken(tokenizer)).type &&
+                    ParseStatement(context, tokenizer, child4)) {
+                        ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
+                        ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
+                        return true;
+                }
+        } else if (Token_KeywordDefault == tokens[0].type) {
+                GetToken(tokenizer);
+                if (Token_Colon == (tokens[1] = GetToken(tokenizer)).type &&
+                    ParseStatement(context, tokenizer, child3)) {
+                        ParseTreeSet(child1, ParseTreeNode_Keyword, tokens[0]);
+                        ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
+                        return true;
+                }
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -1790,46 +1561,50 @@ bool ParseLabeledStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   iteration-statement
   jump-statement
 */
-bool ParseStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStatement(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
+        Tokenizer lookahead = *tokenizer;
+        Token tokens[2];
         ParseTreeNode *child1;
+        bool (*statement)(ParserContext *, Tokenizer *, ParseTreeNode *) = ParseExpressionStatement;
 
         parse_tree->type = ParseTreeNode_Statement;
-        child1 = ParseTreeAddChild(parse_tree);
-
-        if (ParseLabeledStatement(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseExpressionStatement(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseCompoundStatement(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseSelectionStatement(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseIterationStatement(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
+        tokens[0] = GetToken(&lookahead);
+        switch (tokens[0].type) {
+                case Token_OpenBrace: {
+                        statement = ParseCompoundStatement;
+                } break;
+                case Token_Identifier: {
+                        tokens[1] = GetToken(&lookahead);
+                        if (Token_Colon == tokens[1].type) statement = ParseLabeledStatement;
+                } break;
+                case Token_KeywordCase:
+                case Token_KeywordDefault: {
+                        statement = ParseLabeledStatement;
+                } break;
+                case Token_KeywordIf:
+                case Token_KeywordSwitch: {
+                        statement = ParseSelectionStatement;
+                } break;
+                case Token_KeywordWhile:
+                case Token_KeywordDo:
+                case Token_KeywordFor: {
+                        statement = ParseIterationStatement;
+                } break;
+                case Token_KeywordGoto:
+                case Token_KeywordContinue:
+                case Token_KeywordBreak:
+                case Token_KeywordReturn: {
+                        statement = ParseJumpStatement;
+                } break;
+        }
 
-        if (ParseJumpStatement(tokenizer, child1)) return true;
+        if (statement(context, tokenizer, child1)) return true;
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -1839,22 +1614,23 @@ bool ParseStatement(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   typedef-name:
   identifier
 */
-bool ParseTypedefName(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseTypedefName(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token = GetToken(tokenizer);
         ParseTreeNode *child1;
 
         *tokenizer = start;
 
         parse_tree->type = ParseTreeNode_TypedefName;
-        child1 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseIdentifier(tokenizer, child1) && TypedefIsName(token)) {
+        if (ParseIdentifier(context, tokenizer, child1) && TypedefIsName(context, token)) {
                 ParseTreeSet(parse_tree, ParseTreeNode_TypedefName, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -1866,73 +1642,74 @@ bool ParseTypedefName(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   direct-abstract-declarator(opt) [ constant-expression(opt) ]
   direct-abstract-declarator(opt) ( parameter-type-list(opt) )
 */
-bool ParseDirectAbstractDeclaratorI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseDirectAbstractDeclaratorI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[2];
         ParseTreeNode *child1, *child2, *child3, *child4;
 
         parse_tree->type = ParseTreeNode_DirectAbstractDeclaratorI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_OpenBracket == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseConstantExpression(tokenizer, child2) &&
+            ParseConstantExpression(context, tokenizer, child2) &&
             Token_CloseBracket == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectAbstractDeclaratorI(tokenizer, child3)) {
+            ParseDirectAbstractDeclaratorI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenBracket == (tokens[0] = GetToken(tokenizer)).type &&
             Token_CloseBracket == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectAbstractDeclaratorI(tokenizer, child3)) {
+            ParseDirectAbstractDeclaratorI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseParameterTypeList(tokenizer, child2) &&
+            ParseParameterTypeList(context, tokenizer, child2) &&
             Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectAbstractDeclaratorI(tokenizer, child4)) {
+            ParseDirectAbstractDeclaratorI(context, tokenizer, child4)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
             Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectAbstractDeclaratorI(tokenizer, child3)) {
+            ParseDirectAbstractDeclaratorI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -1944,89 +1721,90 @@ bool ParseDirectAbstractDeclaratorI(Tokenizer *tokenizer, ParseTreeNode *parse_t
   direct-abstract-declarator(opt) [ constant-expression(opt) ]
   direct-abstract-declarator(opt) ( parameter-type-list(opt) )
 */
-bool ParseDirectAbstractDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseDirectAbstractDeclarator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[2];
         ParseTreeNode *child1, *child2, *child3, *child4;
 
         parse_tree->type = ParseTreeNode_DirectAbstractDeclarator;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseAbstractDeclarator(tokenizer, child2) &&
+            ParseAbstractDeclarator(context, tokenizer, child2) &&
             Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectAbstractDeclaratorI(tokenizer, child4)) {
+            ParseDirectAbstractDeclaratorI(context, tokenizer, child4)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenBracket == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseConstantExpression(tokenizer, child2) &&
+            ParseConstantExpression(context, tokenizer, child2) &&
             Token_CloseBracket == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectAbstractDeclaratorI(tokenizer, child4)) {
+            ParseDirectAbstractDeclaratorI(context, tokenizer, child4)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenBracket == (tokens[0] = GetToken(tokenizer)).type &&
             Token_CloseBracket == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectAbstractDeclaratorI(tokenizer, child3)) {
+            ParseDirectAbstractDeclaratorI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseParameterTypeList(tokenizer, child2) &&
+            ParseParameterTypeList(context, tokenizer, child2) &&
             Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectAbstractDeclaratorI(tokenizer, child3)) {
+            ParseDirectAbstractDeclaratorI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
             Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectAbstractDeclaratorI(tokenizer, child3)) {
+            ParseDirectAbstractDeclaratorI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -2037,36 +1815,37 @@ bool ParseDirectAbstractDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tr
   pointer
   pointer(opt) direct-abstract-declarator
 */
-bool ParseAbstractDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseAbstractDeclarator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_AbstractDeclarator;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParsePointer(tokenizer, child1) &&
-            ParseDirectAbstractDeclarator(tokenizer, child2)) {
+        if (ParsePointer(context, tokenizer, child1) &&
+            ParseDirectAbstractDeclarator(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseDirectAbstractDeclarator(tokenizer, child1)) {
+        if (ParseDirectAbstractDeclarator(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParsePointer(tokenizer, child1)) {
+        if (ParsePointer(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -2076,52 +1855,58 @@ bool ParseAbstractDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   type-name:
   specifier-qualifier-list abstract-declarator(opt)
 */
-bool ParseTypeName(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool __parser_ParseTypeName(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_TypeName;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseSpecifierQualifierList(tokenizer, child1) &&
-            ParseAbstractDeclarator(tokenizer, child2)) {
+        if (ParseSpecifierQualifierList(context, tokenizer, child1) &&
+            ParseAbstractDeclarator(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseSpecifierQualifierList(tokenizer, child1)) {
+        if (ParseSpecifierQualifierList(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseInitializerListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseTypeName(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return __parser_Memoized(context, ParseMemo_TypeName, __parser_ParseTypeName, tokenizer, parse_tree);
+}
+
+bool ParseInitializerListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_InitializerListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_Comma == (token = GetToken(tokenizer)).type &&
-            ParseInitializer(tokenizer, child2) &&
-            ParseInitializerListI(tokenizer, child3)) {
+            ParseInitializer(context, tokenizer, child2) &&
+            ParseInitializerListI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -2132,20 +1917,21 @@ bool ParseInitializerListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   initializer
   initializer-list , initializer
 */
-bool ParseInitializerList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseInitializerList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_InitializerList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseInitializer(tokenizer, child1) &&
-            ParseInitializerListI(tokenizer, child2)) {
+        if (ParseInitializer(context, tokenizer, child1) &&
+            ParseInitializerListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -2157,45 +1943,46 @@ bool ParseInitializerList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   { initializer-list }
   { initializer-list , }
 */
-bool ParseInitializer(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseInitializer(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[3];
         ParseTreeNode *child1, *child2, *child3, *child4;
 
         parse_tree->type = ParseTreeNode_Initializer;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseAssignmentExpression(tokenizer, child1)) {
+        if (ParseAssignmentExpression(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenBrace == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseInitializerList(tokenizer, child2) &&
+            ParseInitializerList(context, tokenizer, child2) &&
             Token_CloseBrace == (tokens[1] = GetToken(tokenizer)).type) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenBrace == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseInitializerList(tokenizer, child2) &&
+            ParseInitializerList(context, tokenizer, child2) &&
             Token_Comma == (tokens[1] = GetToken(tokenizer)).type &&
             Token_CloseBrace == (tokens[2] = GetToken(tokenizer)).type) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
@@ -2204,30 +1991,31 @@ bool ParseInitializer(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseIdentifierListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseIdentifierListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_IdentifierListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_Comma == (token = GetToken(tokenizer)).type &&
-            ParseIdentifier(tokenizer, child2) &&
-            ParseIdentifierListI(tokenizer, child3)) {
+            ParseIdentifier(context, tokenizer, child2) &&
+            ParseIdentifierListI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -2238,20 +2026,21 @@ bool ParseIdentifierListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   identifier
   identifier-list , identifier
 */
-bool ParseIdentifierList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseIdentifierList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_IdentifierList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseIdentifier(tokenizer, child1) &&
-            ParseIdentifierListI(tokenizer, child2)) {
+        if (ParseIdentifier(context, tokenizer, child1) &&
+            ParseIdentifierListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -2262,62 +2051,64 @@ bool ParseIdentifierList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   declaration-specifiers declarator
   declaration-specifiers abstract-declarator(opt)
 */
-bool ParseParameterDeclaration(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseParameterDeclaration(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_ParameterDeclaration;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseDeclarationSpecifiers(tokenizer, child1) &&
-            ParseDeclarator(tokenizer, child2)) {
+        if (ParseDeclarationSpecifiers(context, tokenizer, child1) &&
+            ParseDeclarator(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseDeclarationSpecifiers(tokenizer, child1) &&
-            ParseAbstractDeclarator(tokenizer, child2)) {
+        if (ParseDeclarationSpecifiers(context, tokenizer, child1) &&
+            ParseAbstractDeclarator(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseDeclarationSpecifiers(tokenizer, child1)) {
+        if (ParseDeclarationSpecifiers(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseParameterListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseParameterListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_ParameterListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_Comma == (token = GetToken(tokenizer)).type &&
-            ParseParameterDeclaration(tokenizer, child2) &&
-            ParseParameterListI(tokenizer, child3)) {
+            ParseParameterDeclaration(context, tokenizer, child2) &&
+            ParseParameterListI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -2328,20 +2119,21 @@ bool ParseParameterListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   parameter-declaration
   parameter-list , parameter-declaration
 */
-bool ParseParameterList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseParameterList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_ParameterList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseParameterDeclaration(tokenizer, child1) &&
-            ParseParameterListI(tokenizer, child2)) {
+        if (ParseParameterDeclaration(context, tokenizer, child1) &&
+            ParseParameterListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -2352,17 +2144,18 @@ bool ParseParameterList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   parameter-list
   parameter-list , ...
 */
-bool ParseParameterTypeList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseParameterTypeList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[2];
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_ParameterTypeList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseParameterList(tokenizer, child1)) {
+        if (ParseParameterList(context, tokenizer, child1)) {
                 Tokenizer Previous = *tokenizer;
                 if (Token_Comma == (tokens[0] = GetToken(tokenizer)).type &&
                     Token_Ellipsis == (tokens[1] = GetToken(tokenizer)).type) {
@@ -2375,26 +2168,27 @@ bool ParseParameterTypeList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseTypeQualifierListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseTypeQualifierListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_TypeQualifierListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseTypeQualifier(tokenizer, child1) &&
-            ParseTypeQualifierListI(tokenizer, child2)) {
+        if (ParseTypeQualifier(context, tokenizer, child1) &&
+            ParseTypeQualifierListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -2405,20 +2199,21 @@ bool ParseTypeQualifierListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   type-qualifier
   type-qualifier-list type-qualifier
 */
-bool ParseTypeQualifierList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseTypeQualifierList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_TypeQualifierList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseTypeQualifier(tokenizer, child1) &&
-            ParseTypeQualifierListI(tokenizer, child2)) {
+        if (ParseTypeQualifier(context, tokenizer, child1) &&
+            ParseTypeQualifierListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -2429,15 +2224,16 @@ bool ParseTypeQualifierList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   * type-qualifier-list(opt)
   * type-qualifier-list(opt) pointer
   */
-bool ParsePointer(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParsePointer(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token = GetToken(tokenizer);
         Tokenizer at_token = *tokenizer;
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_Pointer;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_Asterisk != token.type) {
                 *tokenizer = start;
@@ -2446,30 +2242,30 @@ bool ParsePointer(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
 
         ParseTreeSet(parse_tree, ParseTreeNode_Pointer, token);
 
-        if (ParseTypeQualifierList(tokenizer, child1) &&
-            ParsePointer(tokenizer, child2)) {
+        if (ParseTypeQualifierList(context, tokenizer, child1) &&
+            ParsePointer(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = at_token;
 
-        if (ParsePointer(tokenizer, child1)) {
+        if (ParsePointer(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = at_token;
 
-        if (ParseTypeQualifierList(tokenizer, child1)) {
+        if (ParseTypeQualifierList(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = at_token;
 
         return true;
@@ -2491,89 +2287,90 @@ bool ParsePointer(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   A' → (E)A' | ε
   A' → (F)A' | ε
 */
-bool ParseDirectDeclaratorI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseDirectDeclaratorI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[2];
         ParseTreeNode *child1, *child2, *child3, *child4;
 
         parse_tree->type = ParseTreeNode_DirectDeclaratorI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_OpenBracket == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseConstantExpression(tokenizer, child2) &&
+            ParseConstantExpression(context, tokenizer, child2) &&
             Token_CloseBracket == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectDeclaratorI(tokenizer, child4)) {
+            ParseDirectDeclaratorI(context, tokenizer, child4)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenBracket == (tokens[0] = GetToken(tokenizer)).type &&
             Token_CloseBracket == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectDeclaratorI(tokenizer, child3)) {
+            ParseDirectDeclaratorI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseParameterTypeList(tokenizer, child2) &&
+            ParseParameterTypeList(context, tokenizer, child2) &&
             Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectDeclaratorI(tokenizer, child4)) {
+            ParseDirectDeclaratorI(context, tokenizer, child4)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseIdentifierList(tokenizer, child2) &&
+            ParseIdentifierList(context, tokenizer, child2) &&
             Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectDeclaratorI(tokenizer, child4)) {
+            ParseDirectDeclaratorI(context, tokenizer, child4)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
             Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectDeclaratorI(tokenizer, child3)) {
+            ParseDirectDeclaratorI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -2595,39 +2392,40 @@ bool ParseDirectDeclaratorI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   A' → (E)A' | ε
   A' → (F)A' | ε
 */
-bool ParseDirectDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseDirectDeclarator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token tokens[2];
         ParseTreeNode *child1, *child2, *child3, *child4;
 
         parse_tree->type = ParseTreeNode_DirectDeclarator;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseIdentifier(tokenizer, child1) &&
-            ParseDirectDeclaratorI(tokenizer, child2)) {
+        if (ParseIdentifier(context, tokenizer, child1) &&
+            ParseDirectDeclaratorI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_OpenParen == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseDeclarator(tokenizer, child2) &&
+            ParseDeclarator(context, tokenizer, child2) &&
             Token_CloseParen == (tokens[1] = GetToken(tokenizer)).type &&
-            ParseDirectDeclaratorI(tokenizer, child4)) {
+            ParseDirectDeclaratorI(context, tokenizer, child4)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -2637,87 +2435,94 @@ bool ParseDirectDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   declarator:
   pointer(opt) direct-declarator
 */
-bool ParseDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool __parser_ParseDeclarator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_Declarator;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParsePointer(tokenizer, child1) &&
-            ParseDirectDeclarator(tokenizer, child2)) {
+        if (ParsePointer(context, tokenizer, child1) &&
+            ParseDirectDeclarator(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseDirectDeclarator(tokenizer, child1)) {
+        if (ParseDirectDeclarator(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
+bool ParseDeclarator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return __parser_Memoized(context, ParseMemo_Declarator, __parser_ParseDeclarator, tokenizer, parse_tree);
+}
+
 /*
   enumerator:
   identifier
   identifier = constant-expression
 */
-bool ParseEnumerator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseEnumerator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_Enumerator;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseIdentifier(tokenizer, child1) &&
+        if (ParseIdentifier(context, tokenizer, child1) &&
             Token_EqualSign == (token = GetToken(tokenizer)).type &&
-            ParseConstantExpression(tokenizer, child3)) {
+            ParseConstantExpression(context, tokenizer, child3)) {
                 ParseTreeSet(child2, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseIdentifier(tokenizer, child1)) {
+        if (ParseIdentifier(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseEnumeratorListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseEnumeratorListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_EnumeratorListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_Comma == (token = GetToken(tokenizer)).type &&
-            ParseEnumerator(tokenizer, child2) &&
-            ParseEnumeratorListI(tokenizer, child3)) {
+            ParseEnumerator(context, tokenizer, child2) &&
+            ParseEnumeratorListI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -2733,20 +2538,21 @@ bool ParseEnumeratorListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   A  → BA'
   A' → ,BA' | ε
 */
-bool ParseEnumeratorList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseEnumeratorList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_EnumeratorList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseEnumerator(tokenizer, child1) &&
-            ParseEnumeratorListI(tokenizer, child2)) {
+        if (ParseEnumerator(context, tokenizer, child1) &&
+            ParseEnumeratorListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -2757,31 +2563,31 @@ bool ParseEnumeratorList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   enum identifier(opt) { enumerator-list }
   enum identifier
 */
-bool ParseEnumSpecifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseEnumSpecifier(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token = GetToken(tokenizer);
         Tokenizer at_token = *tokenizer;
         Token tokens[2];
         ParseTreeNode *child1, *child2, *child3, *child4, *child5;
 
         parse_tree->type = ParseTreeNode_EnumSpecifier;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        child5 = ParseTreeAddChild(parse_tree);
-
-        if (!(Token_Keyword == token.type &&
-              gs_StringIsEqual("enum", token.text, token.text_length))) {
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
+        child5 = ParseTreeAddChild(&context->tree, parse_tree);
+
+        if (Token_KeywordEnum != token.type) {
                 *tokenizer = start;
                 return false;
         }
 
         ParseTreeSet(child1, ParseTreeNode_Keyword, token);
 
-        if (ParseIdentifier(tokenizer, child2) &&
+        if (ParseIdentifier(context, tokenizer, child2) &&
             Token_OpenBrace == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseEnumeratorList(tokenizer, child4) &&
+            ParseEnumeratorList(context, tokenizer, child4) &&
             Token_CloseBrace == (tokens[1] = GetToken(tokenizer)).type) {
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child5, ParseTreeNode_Symbol, tokens[1]);
@@ -2789,30 +2595,30 @@ bool ParseEnumSpecifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         }
 
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = at_token;
 
         if (Token_OpenBrace == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseEnumeratorList(tokenizer, child3) &&
+            ParseEnumeratorList(context, tokenizer, child3) &&
             Token_CloseBrace == (tokens[1] = GetToken(tokenizer)).type) {
                 ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = at_token;
 
-        if (ParseIdentifier(tokenizer, child1)) {
+        if (ParseIdentifier(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -2823,66 +2629,68 @@ bool ParseEnumSpecifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   declarator
   declarator(opt) : constant-expression
 */
-bool ParseStructDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStructDeclarator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_StructDeclarator;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseDeclarator(tokenizer, child1) &&
+        if (ParseDeclarator(context, tokenizer, child1) &&
             Token_Colon == (token = GetToken(tokenizer)).type &&
-            ParseConstantExpression(tokenizer, child3)) {
+            ParseConstantExpression(context, tokenizer, child3)) {
                 ParseTreeSet(child2, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
         if (Token_Colon == (token = GetToken(tokenizer)).type &&
-            ParseConstantExpression(tokenizer, child2)) {
+            ParseConstantExpression(context, tokenizer, child2)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseDeclarator(tokenizer, child1)) {
+        if (ParseDeclarator(context, tokenizer, child1)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseStructDeclaratorListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStructDeclaratorListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_StructDeclaratorListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_Comma == (token = GetToken(tokenizer)).type &&
-            ParseStructDeclarator(tokenizer, child2) &&
-            ParseStructDeclaratorListI(tokenizer, child3)) {
+            ParseStructDeclarator(context, tokenizer, child2) &&
+            ParseStructDeclaratorListI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -2898,20 +2706,21 @@ bool ParseStructDeclaratorListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree)
   Sdl  → Sd Sdl'
   Sdl' → , Sd Sdl' | ε
 */
-bool ParseStructDeclaratorList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStructDeclaratorList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_StructDeclaratorList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseStructDeclarator(tokenizer, child1) &&
-            ParseStructDeclaratorListI(tokenizer, child2)) {
+        if (ParseStructDeclarator(context, tokenizer, child1) &&
+            ParseStructDeclaratorListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -2922,43 +2731,44 @@ bool ParseStructDeclaratorList(Tokenizer *tokenizer, ParseTreeNode *parse_tree)
   type-specifier specifier-qualifier-list(opt)
   type-qualifier specifier-qualifier-list(opt)
 */
-bool ParseSpecifierQualifierList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseSpecifierQualifierList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_SpecifierQualifierList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseTypeSpecifier(tokenizer, child1) &&
-            ParseSpecifierQualifierList(tokenizer, child2)) {
+        if (ParseTypeSpecifier(context, tokenizer, child1) &&
+            ParseSpecifierQualifierList(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseTypeSpecifier(tokenizer, child1)) return true;
+        if (ParseTypeSpecifier(context, tokenizer, child1)) return true;
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseTypeQualifier(tokenizer, child1) &&
-            ParseSpecifierQualifierList(tokenizer, child2)) {
+        if (ParseTypeQualifier(context, tokenizer, child1) &&
+            ParseSpecifierQualifierList(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseTypeQualifier(tokenizer, child1)) return true;
+        if (ParseTypeQualifier(context, tokenizer, child1)) return true;
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -2968,24 +2778,25 @@ bool ParseSpecifierQualifierList(Tokenizer *tokenizer, ParseTreeNode *parse_tree
   struct-declaration:
   specifier-qualifier-list struct-declarator-list ;
 */
-bool ParseStructDeclaration(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStructDeclaration(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_StructDeclaration;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseSpecifierQualifierList(tokenizer, child1) &&
-            ParseStructDeclaratorList(tokenizer, child2) &&
+        if (ParseSpecifierQualifierList(context, tokenizer, child1) &&
+            ParseStructDeclaratorList(context, tokenizer, child2) &&
             Token_SemiColon == (token = GetToken(tokenizer)).type) {
                 ParseTreeSet(child3, ParseTreeNode_StructDeclaration, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -2996,53 +2807,55 @@ bool ParseStructDeclaration(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   declarator
   declarator = initializer
 */
-bool ParseInitDeclarator(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseInitDeclarator(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_InitDeclarator;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseDeclarator(tokenizer, child1) &&
+        if (ParseDeclarator(context, tokenizer, child1) &&
             Token_EqualSign == (token = GetToken(tokenizer)).type &&
-            ParseInitializer(tokenizer, child3)) {
+            ParseInitializer(context, tokenizer, child3)) {
                 ParseTreeSet(child2, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseDeclarator(tokenizer, child1)) return true;
+        if (ParseDeclarator(context, tokenizer, child1)) return true;
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseInitDeclaratorListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseInitDeclaratorListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
         ParseTreeNode *child1, *child2, *child3;
 
         parse_tree->type = ParseTreeNode_InitDeclaratorListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
 
         if (Token_Comma == (token = GetToken(tokenizer)).type &&
-            ParseInitDeclarator(tokenizer, child2) &&
-            ParseInitDeclaratorListI(tokenizer, child3)) {
+            ParseInitDeclarator(context, tokenizer, child2) &&
+            ParseInitDeclaratorListI(context, tokenizer, child3)) {
                 ParseTreeSet(child1, ParseTreeNode_Symbol, token);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -3058,39 +2871,41 @@ bool ParseInitDeclaratorListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   Idl  → Id Idl'
   Idl' → , Id Idl' | ε
 */
-bool ParseInitDeclaratorList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseInitDeclaratorList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_InitDeclarationList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseInitDeclarator(tokenizer, child1) &&
-            ParseInitDeclaratorListI(tokenizer, child2)) {
+        if (ParseInitDeclarator(context, tokenizer, child1) &&
+            ParseInitDeclaratorListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
 }
 
-bool ParseStructDeclarationListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStructDeclarationListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_StructDeclarationListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseStructDeclaration(tokenizer, child1) &&
-            ParseStructDeclarationListI(tokenizer, child2)) {
+        if (ParseStructDeclaration(context, tokenizer, child1) &&
+            ParseStructDeclarationListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -3106,20 +2921,21 @@ bool ParseStructDeclarationListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree
   Sdl  → Sd Sdl'
   Sdl' → Sd Sdl' | ε
 */
-bool ParseStructDeclarationList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStructDeclarationList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_StructDeclarationList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseStructDeclaration(tokenizer, child1) &&
-            ParseStructDeclarationListI(tokenizer, child2)) {
+        if (ParseStructDeclaration(context, tokenizer, child1) &&
+            ParseStructDeclarationListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -3129,16 +2945,14 @@ bool ParseStructDeclarationList(Tokenizer *tokenizer, ParseTreeNode *parse_tree)
   struct-or-union:
   One of: struct union
 */
-bool ParseStructOrUnion(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStructOrUnion(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        (void)context;
         Tokenizer start = *tokenizer;
         Token token = GetToken(tokenizer);
 
-        if (Token_Keyword == token.type) {
-                if (gs_StringIsEqual(token.text, "struct", token.text_length) ||
-                    gs_StringIsEqual(token.text, "union", token.text_length)) {
-                        ParseTreeSet(parse_tree, ParseTreeNode_StructOrUnion, token);
-                        return true;
-                }
+        if (Token_KeywordStruct == token.type || Token_KeywordUnion == token.type) {
+                ParseTreeSet(parse_tree, ParseTreeNode_StructOrUnion, token);
+                return true;
         }
 
         *tokenizer = start;
@@ -3151,56 +2965,57 @@ bool ParseStructOrUnion(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   struct-or-union identifier(opt) { struct-declaration-list }
   struct-or-union identifier
 */
-bool ParseStructOrUnionSpecifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStructOrUnionSpecifier(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2, *child3, *child4, *child5;
 
         parse_tree->type = ParseTreeNode_StructOrUnionSpecifier;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
-        child5 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
+        child5 = ParseTreeAddChild(&context->tree, parse_tree);
 
         Token tokens[2];
 
-        if (ParseStructOrUnion(tokenizer, child1) &&
-            ParseIdentifier(tokenizer, child2) &&
+        if (ParseStructOrUnion(context, tokenizer, child1) &&
+            ParseIdentifier(context, tokenizer, child2) &&
             Token_OpenBrace == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseStructDeclarationList(tokenizer, child4) &&
+            ParseStructDeclarationList(context, tokenizer, child4) &&
             Token_CloseBrace == (tokens[1] = GetToken(tokenizer)).type) {
                 ParseTreeSet(child3, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child5, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
+        child3 = ParseTreeAddChild(&context->tree, parse_tree);
+        child4 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseStructOrUnion(tokenizer, child1) &&
+        if (ParseStructOrUnion(context, tokenizer, child1) &&
             Token_OpenBrace == (tokens[0] = GetToken(tokenizer)).type &&
-            ParseStructDeclarationList(tokenizer, child3) &&
+            ParseStructDeclarationList(context, tokenizer, child3) &&
             Token_CloseBrace == (tokens[1] = GetToken(tokenizer)).type) {
                 ParseTreeSet(child2, ParseTreeNode_Symbol, tokens[0]);
                 ParseTreeSet(child4, ParseTreeNode_Symbol, tokens[1]);
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
         *tokenizer = start;
 
-        if (ParseStructOrUnion(tokenizer, child1) &&
-            ParseIdentifier(tokenizer, child2)) {
+        if (ParseStructOrUnion(context, tokenizer, child1) &&
+            ParseIdentifier(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -3210,16 +3025,14 @@ bool ParseStructOrUnionSpecifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree
   type-qualifier:
   One of: const volatile
 */
-bool ParseTypeQualifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseTypeQualifier(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        (void)context;
         Tokenizer start = *tokenizer;
         Token token = GetToken(tokenizer);
 
-        if (token.type == Token_Keyword) {
-                if (gs_StringIsEqual(token.text, "const", token.text_length) ||
-                    gs_StringIsEqual(token.text, "volatile", token.text_length)) {
-                        ParseTreeSet(parse_tree, ParseTreeNode_TypeQualifier, token);
-                        return true;
-                }
+        if (__parser_IsTypeQualifierKeyword(token.type)) {
+                ParseTreeSet(parse_tree, ParseTreeNode_TypeQualifier, token);
+                return true;
         }
 
         *tokenizer = start;
@@ -3232,42 +3045,37 @@ bool ParseTypeQualifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   One of: void char short int long float double signed unsigned
   struct-or-union-specifier enum-specifier typedef-name
 */
-bool ParseTypeSpecifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseTypeSpecifier(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
-        char *keywords[] = { "void", "char", "short", "int", "long", "float",
-                             "double", "signed", "unsigned" };
-
-        Token token = GetToken(tokenizer);
-        if (token.type == Token_Keyword) {
-                for (int i = 0; i < gs_ArraySize(keywords); i++) {
-                        if (gs_StringIsEqual(token.text, keywords[i], token.text_length)) {
-                                ParseTreeSet(parse_tree, ParseTreeNode_TypeSpecifier, token);
-                                return true;
-                        }
-                }
-        }
-
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1;
 
         parse_tree->type = ParseTreeNode_TypeSpecifier;
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseStructOrUnionSpecifier(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
 
-        if (ParseEnumSpecifier(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
+        Token token = PeekToken(tokenizer);
+        if (__parser_IsBasicTypeKeyword(token.type)) {
+                GetToken(tokenizer);
+                ParseTreeSet(parse_tree, ParseTreeNode_TypeSpecifier, token);
+                return true;
+        }
 
-        if (ParseTypedefName(tokenizer, child1)) return true;
+        switch (token.type) {
+                case Token_KeywordStruct:
+                case Token_KeywordUnion: {
+                        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+                        if (ParseStructOrUnionSpecifier(context, tokenizer, child1)) return true;
+                } break;
+                case Token_KeywordEnum: {
+                        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+                        if (ParseEnumSpecifier(context, tokenizer, child1)) return true;
+                } break;
+                case Token_Identifier: {
+                        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+                        if (ParseTypedefName(context, tokenizer, child1)) return true;
+                } break;
+        }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
@@ -3277,18 +3085,13 @@ bool ParseTypeSpecifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   storage-class-specifier:
   One of: auto register static extern typedef
 */
-bool ParseStorageClassSpecifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseStorageClassSpecifier(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        (void)context;
         Tokenizer start = *tokenizer;
-        char *keywords[] = { "auto", "register", "static", "extern", "typedef" };
-
         Token token = GetToken(tokenizer);
-        if (token.type == Token_Keyword) {
-                for (int i = 0; i < gs_ArraySize(keywords); i++) {
-                        if (gs_StringIsEqual(token.text, keywords[i], token.text_length)) {
-                                ParseTreeSet(parse_tree, ParseTreeNode_StorageClassSpecifier, token);
-                                return true;
-                        }
-                }
+        if (__parser_IsStorageClassKeyword(token.type)) {
+                ParseTreeSet(parse_tree, ParseTreeNode_StorageClassSpecifier, token);
+                return true;
         }
 
         *tokenizer = start;
@@ -3302,83 +3105,58 @@ bool ParseStorageClassSpecifier(Tokenizer *tokenizer, ParseTreeNode *parse_tree)
   type-specifier declaration-specifiers(opt)
   type-qualifier declaration-specifiers(opt)
 */
-bool ParseDeclarationSpecifiers(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool __parser_ParseDeclarationSpecifiers(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
+        bool (*specifier)(ParserContext *, Tokenizer *, ParseTreeNode *) = ParseTypeSpecifier;
         ParseTreeNode *child1, *child2;
 
-        parse_tree->type = ParseTreeNode_DeclarationSpecifiers;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-
-        if (ParseStorageClassSpecifier(tokenizer, child1) &&
-            ParseDeclarationSpecifiers(tokenizer, child2)) {
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseTypeSpecifier(tokenizer, child1) &&
-            ParseDeclarationSpecifiers(tokenizer, child2)) {
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseTypeQualifier(tokenizer, child1) &&
-            ParseDeclarationSpecifiers(tokenizer, child2)) {
-                return true;
-        }
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseStorageClassSpecifier(tokenizer, child1)) {
-                return true;
+        Token token = PeekToken(tokenizer);
+        if (__parser_IsStorageClassKeyword(token.type)) {
+                specifier = ParseStorageClassSpecifier;
+        } else if (__parser_IsTypeQualifierKeyword(token.type)) {
+                specifier = ParseTypeQualifier;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseTypeSpecifier(tokenizer, child1)) {
-                return true;
-        }
+        parse_tree->type = ParseTreeNode_DeclarationSpecifiers;
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
+        if (specifier(context, tokenizer, child1)) {
+                Tokenizer after_specifier = *tokenizer;
+                if (ParseDeclarationSpecifiers(context, tokenizer, child2)) return true;
 
-        if (ParseTypeQualifier(tokenizer, child1)) {
+                /* The trailing declaration-specifiers are optional. */
+                child2->type = ParseTreeNode_Unknown;
+                *tokenizer = after_specifier;
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseDeclarationListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseDeclarationSpecifiers(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        return __parser_Memoized(context, ParseMemo_DeclarationSpecifiers, __parser_ParseDeclarationSpecifiers, tokenizer, parse_tree);
+}
+
+bool ParseDeclarationListI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_DeclarationListI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseDeclaration(tokenizer, child1) &&
-            ParseDeclarationListI(tokenizer, child2)) {
+        if (ParseDeclaration(context, tokenizer, child1) &&
+            ParseDeclarationListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -3394,124 +3172,116 @@ bool ParseDeclarationListI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   Dl  → D Dl'
   Dl' → D Dl' | ε
 */
-bool ParseDeclarationList(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseDeclarationList(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_DeclarationList;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseDeclaration(tokenizer, child1) &&
-            ParseDeclarationListI(tokenizer, child2)) {
+        if (ParseDeclaration(context, tokenizer, child1) &&
+            ParseDeclarationListI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
 /*
-  declaration:
-  declaration-specifiers init-declarator-list(opt) ;
+  function-definition and declaration both begin with
+  declaration-specifiers(opt) declarator, so that prefix is parsed once and
+  the token after it picks the rule: `=', `,' or `;' finish a declaration,
+  anything else goes on to a function body with an optional K&R
+  declaration-list. parse_tree becomes whichever node was parsed.
 */
-bool ParseDeclaration(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool __parser_ParseDeclarationOrFunctionDefinition(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree, bool allow_declaration, bool allow_function) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         Token token;
-        ParseTreeNode *child1, *child2, *child3;
-
-        parse_tree->type = ParseTreeNode_Declaration;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+        ParseTreeNode *specifiers, *declarator;
 
-        if (ParseDeclarationSpecifiers(tokenizer, child1) &&
-            ParseInitDeclaratorList(tokenizer, child2) &&
-            Token_SemiColon == (token = GetToken(tokenizer)).type) {
-                ParseTreeSet(child3, ParseTreeNode_Symbol, token);
-                return true;
+        specifiers = ParseTreeAddChild(&context->tree, parse_tree);
+        bool has_specifiers = ParseDeclarationSpecifiers(context, tokenizer, specifiers);
+        if (!has_specifiers) {
+                specifiers->type = ParseTreeNode_Unknown;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
-
-        if (ParseDeclarationSpecifiers(tokenizer, child1) &&
-            Token_SemiColon == (token = GetToken(tokenizer)).type) {
-                ParseTreeSet(child2, ParseTreeNode_Symbol, token);
+        if (has_specifiers && allow_declaration && Token_SemiColon == PeekToken(tokenizer).type) {
+                parse_tree->type = ParseTreeNode_Declaration;
+                ParseTreeAddChild(&context->tree, parse_tree)->type = ParseTreeNode_InitDeclarationList;
+                ParseTreeSet(ParseTreeAddChild(&context->tree, parse_tree), ParseTreeNode_Symbol, GetToken(tokenizer));
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
-
-        return false;
-}
+        declarator = ParseTreeAddChild(&context->tree, parse_tree);
+        if ((has_specifiers || allow_function) && ParseDeclarator(context, tokenizer, declarator)) {
+                token = PeekToken(tokenizer);
+                bool ends_declarator = Token_EqualSign == token.type ||
+                        Token_Comma == token.type ||
+                        Token_SemiColon == token.type;
 
-/*
-  function-definition:
-  declaration-specifiers(opt) declarator declaration-list(opt) compound-statement
-*/
-bool ParseFunctionDefinition(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
-        Tokenizer start = *tokenizer;
-        ParseTreeNode *child1, *child2, *child3, *child4;
+                if (ends_declarator && has_specifiers && allow_declaration) {
+                        parse_tree->type = ParseTreeNode_Declaration;
 
-        parse_tree->type = ParseTreeNode_FunctionDefinition;
+                        /* The declarator becomes the first init-declarator of the list. */
+                        ParseTreePushDown(&context->tree, declarator);
+                        declarator->type = ParseTreeNode_InitDeclarator;
 
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-        child4 = ParseTreeAddChild(parse_tree);
+                        bool initialized = true;
+                        if (Token_EqualSign == token.type) {
+                                ParseTreeSet(ParseTreeAddChild(&context->tree, declarator), ParseTreeNode_Symbol, GetToken(tokenizer));
+                                initialized = ParseInitializer(context, tokenizer, ParseTreeAddChild(&context->tree, declarator));
+                        }
 
-        if (ParseDeclarationSpecifiers(tokenizer, child1) &&
-            ParseDeclarator(tokenizer, child2) &&
-            ParseDeclarationList(tokenizer, child3) &&
-            ParseCompoundStatement(tokenizer, child4)) {
-                return true;
-        }
+                        ParseTreePushDown(&context->tree, declarator);
+                        declarator->type = ParseTreeNode_InitDeclarationList;
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
+                        if (initialized &&
+                            ParseInitDeclaratorListI(context, tokenizer, ParseTreeAddChild(&context->tree, declarator)) &&
+                            Token_SemiColon == (token = GetToken(tokenizer)).type) {
+                                ParseTreeSet(ParseTreeAddChild(&context->tree, parse_tree), ParseTreeNode_Symbol, token);
+                                return true;
+                        }
+                } else if (!ends_declarator && allow_function) {
+                        parse_tree->type = ParseTreeNode_FunctionDefinition;
 
-        *tokenizer = start;
-        if (ParseDeclarationSpecifiers(tokenizer, child1) &&
-            ParseDeclarator(tokenizer, child2) &&
-            ParseCompoundStatement(tokenizer, child3)) {
-                return true;
+                        if ((Token_OpenBrace == token.type ||
+                             ParseDeclarationList(context, tokenizer, ParseTreeAddChild(&context->tree, parse_tree))) &&
+                            ParseCompoundStatement(context, tokenizer, ParseTreeAddChild(&context->tree, parse_tree))) {
+                                return true;
+                        }
+                }
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
-        child3 = ParseTreeAddChild(parse_tree);
-
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
-        if (ParseDeclarator(tokenizer, child1) &&
-            ParseDeclarationList(tokenizer, child2) &&
-            ParseCompoundStatement(tokenizer, child3)) {
-                return true;
-        }
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        return false;
+}
 
-        *tokenizer = start;
-        if (ParseDeclarator(tokenizer, child1) &&
-            ParseCompoundStatement(tokenizer, child2)) {
-                return true;
-        }
+/*
+  declaration:
+  declaration-specifiers init-declarator-list(opt) ;
+*/
+bool ParseDeclaration(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        parse_tree->type = ParseTreeNode_Declaration;
 
-        ParseTreeRemoveAllChildren(parse_tree);
-        *tokenizer = start;
+        return __parser_ParseDeclarationOrFunctionDefinition(context, tokenizer, parse_tree, true, false);
+}
 
-        return false;
+/*
+  function-definition:
+  declaration-specifiers(opt) declarator declaration-list(opt) compound-statement
+*/
+bool ParseFunctionDefinition(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+        parse_tree->type = ParseTreeNode_FunctionDefinition;
+
+        return __parser_ParseDeclarationOrFunctionDefinition(context, tokenizer, parse_tree, false, true);
 }
 
 /*
@@ -3519,41 +3289,37 @@ bool ParseFunctionDefinition(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   function-definition
   declaration
 */
-bool ParseExternalDeclaration(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseExternalDeclaration(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1;
 
         parse_tree->type = ParseTreeNode_ExternalDeclaration;
-        child1 = ParseTreeAddChild(parse_tree);
-
-        if (ParseFunctionDefinition(tokenizer, child1)) return true;
-
-        ParseTreeRemoveAllChildren(parse_tree);
-        child1 = ParseTreeAddChild(parse_tree);
-        *tokenizer = start;
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseDeclaration(tokenizer, child1)) return true;
+        if (__parser_ParseDeclarationOrFunctionDefinition(context, tokenizer, child1, true, true)) return true;
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool ParseTranslationUnitI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseTranslationUnitI(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_TranslationUnitI;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseExternalDeclaration(tokenizer, child1) &&
-            ParseTranslationUnitI(tokenizer, child2)) {
+        if (ParseExternalDeclaration(context, tokenizer, child1) &&
+            ParseTranslationUnitI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return true;
@@ -3569,38 +3335,149 @@ bool ParseTranslationUnitI(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
   Tu  → Ed Tu'
   Tu' → Ed Tu' | ε
 */
-bool ParseTranslationUnit(Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
+bool ParseTranslationUnit(ParserContext *context, Tokenizer *tokenizer, ParseTreeNode *parse_tree) {
         Tokenizer start = *tokenizer;
+        ParseMark mark = __parser_Mark(context);
         ParseTreeNode *child1, *child2;
 
         parse_tree->type = ParseTreeNode_TranslationUnit;
-        child1 = ParseTreeAddChild(parse_tree);
-        child2 = ParseTreeAddChild(parse_tree);
+        child1 = ParseTreeAddChild(&context->tree, parse_tree);
+        child2 = ParseTreeAddChild(&context->tree, parse_tree);
 
-        if (ParseExternalDeclaration(tokenizer, child1) &&
-            ParseTranslationUnitI(tokenizer, child2)) {
+        if (ParseExternalDeclaration(context, tokenizer, child1) &&
+            ParseTranslationUnitI(context, tokenizer, child2)) {
                 return true;
         }
 
-        ParseTreeRemoveAllChildren(parse_tree);
+        __parser_Rollback(context, parse_tree, mark);
         *tokenizer = start;
 
         return false;
 }
 
-bool Parse(gs_Allocator allocator, gs_Buffer *stream, ParseTreeNode **out_tree, Tokenizer *out_tokenizer) {
-        __parser_allocator = allocator;
-        ParseTreeNode *parse_tree = ParseTreeInit(allocator);
+/*
+  Lexes `stream' once into `tokens' and points `tokenizer' at them, so that
+  backtracking only resets an index instead of re-lexing text.
+*/
+bool __parser_Begin(ParserContext *context, gs_Buffer *stream, Tokenizer *tokenizer, TokenStream *tokens) {
+        TokenizerInit(tokenizer, stream->start);
+        TokenizerSetSymbols(tokenizer, __parser_Symbols(context));
+
+        u32 size_hint = LexerEstimateTokens(stream->start, stream->length);
+        if (!LexTokenizerCompact(&context->lexer, tokenizer, size_hint, tokens)) return false;
+
+        TokenizerInit(tokenizer, stream->start);
+        TokenizerSetStream(tokenizer, tokens);
+
+        TypedefInit(context);
+
+        return true;
+}
+
+/*
+  The tree is released with ParseTreeDeinit(&context->tree, *out_tree), even if
+  the parse failed. It is null if it couldn't be allocated, which the tree
+  context's error reports.
+*/
+bool Parse(ParserContext *context, gs_Buffer *stream, ParseTreeNode **out_tree, Tokenizer *out_tokenizer) {
+        ParseTreeNode *parse_tree = ParseTreeInitArena(&context->tree);
+        *out_tree = parse_tree;
+        if (parse_tree == GS_NULL_PTR) {
+                TokenizerInit(out_tokenizer, stream->start);
+                return false;
+        }
 
         Tokenizer tokenizer;
-        tokenizer.beginning = tokenizer.at = stream->start;
-        tokenizer.line = tokenizer.column = 1;
+        TokenStream tokens;
+        if (!__parser_Begin(context, stream, &tokenizer, &tokens)) {
+                *out_tokenizer = tokenizer;
+                return false;
+        }
+
+        bool memoize = context->memoize && __parser_MemoInit(context, tokens.num_tokens);
 
-        TypedefInit(__parser_typedef_names);
+        bool result = ParseTranslationUnit(context, &tokenizer, parse_tree);
 
-        bool result = ParseTranslationUnit(&tokenizer, parse_tree);
+        if (memoize) __parser_MemoDeinit(context);
+        if (result && context->compact) ParseTreeCompact(&context->tree, parse_tree);
+        TokenizerSetStream(&tokenizer, GS_NULL_PTR);
+        *out_tokenizer = tokenizer;
+        TokenStreamDeinit(&tokens);
+
+        return result;
+}
+
+/*
+  Parses into a flat tree shaped exactly like the one Parse builds, without
+  ever holding that whole tree. An external declaration is never backtracked
+  over once parsed, so each one is parsed into the arena, appended to the
+  flat tree and released before the next; the translation unit's own nodes
+  are written straight into the flat tree. Only the largest declaration is
+  ever held in pointer form. The tree is only valid, and only needs
+  ParseFlatTreeDeinit, if the parse succeeded.
+*/
+bool ParseFlat(ParserContext *context, gs_Buffer *stream, ParseFlatTree *out_tree, Tokenizer *out_tokenizer) {
+        Tokenizer tokenizer;
+        TokenStream tokens;
+        if (!__parser_Begin(context, stream, &tokenizer, &tokens)) {
+                *out_tokenizer = tokenizer;
+                return false;
+        }
+
+        ParseFlatTreeInit(out_tree, context->allocator, &tokens);
+        bool memoize = context->memoize && __parser_MemoInit(context, tokens.num_tokens);
+        ParseTreeNode *scratch = ParseTreeInitArena(&context->tree);
+
+        ParseTreeNode spine;
+        __ParseTreeInit(&context->tree, &spine);
+        spine.type = ParseTreeNode_TranslationUnit;
+        u32 parent = ParseFlatTreeAppend(out_tree, &spine);
+        spine.type = ParseTreeNode_TranslationUnitI;
+
+        /*
+          translation-unit and each translation-unit' hold one external
+          declaration and the translation-unit' after it, which is left empty
+          once no declaration follows.
+        */
+        bool result = (scratch != GS_NULL_PTR && parent != PARSE_FLAT_TREE_NONE);
+        while (result) {
+                if (memoize) __parser_MemoForget(context, tokenizer.cursor);
+                ParseMark mark = __parser_Mark(context);
+
+                ParseTreeNode *declaration = ParseTreeAddChild(&context->tree, scratch);
+                if (declaration == GS_NULL_PTR) {
+                        result = false;
+                        break;
+                }
+
+                bool parsed = ParseExternalDeclaration(context, &tokenizer, declaration);
+                u32 index = parsed ? ParseFlatTreeAppend(out_tree, declaration) : PARSE_FLAT_TREE_NONE;
+                ParseTreeRollback(&context->tree, scratch, mark.arena);
+
+                if (!parsed) {
+                        /* translation-unit needs at least one declaration. */
+                        result = (parent != 0);
+                        break;
+                }
+
+                u32 tail = ParseFlatTreeAppend(out_tree, &spine);
+                if (index == PARSE_FLAT_TREE_NONE || tail == PARSE_FLAT_TREE_NONE) {
+                        result = false;
+                        break;
+                }
+
+                out_tree->first_child[parent] = index;
+                out_tree->next_sibling[index] = tail;
+                parent = tail;
+        }
+
+        ParseTreeDeinit(&context->tree, scratch);
+        if (memoize) __parser_MemoDeinit(context);
+        if (result && context->compact) result = ParseFlatTreeCompact(out_tree);
+        if (!result) ParseFlatTreeDeinit(out_tree);
+
+        TokenizerSetStream(&tokenizer, GS_NULL_PTR);
         *out_tokenizer = tokenizer;
-        *out_tree = parse_tree;
 
         return result;
 }
@@ -17,40 +17,758 @@
 #include "parser.c"
 #include "parse_tree.c"
 
-typedef bool (*parser_function)(struct tokenizer *, parse_tree_node *);
+typedef bool (*parser_function)(ParserContext *, Tokenizer *, ParseTreeNode *);
 
-parse_tree_allocator Allocator = { .Alloc = malloc, .Free = free };
+gs_Allocator allocator = { .malloc = malloc, .free = free, .realloc = realloc, .calloc = calloc };
+ParserContext context;
 
+/* Each rule is run twice: lexing on demand, and over a pre-lexed token stream. */
 #define Accept(Function, String) \
         { \
-                parse_tree_node *ParseTree = ParseTreeInit(Allocator); \
-                struct tokenizer Tokenizer = InitTokenizer((String)); \
-                bool Result = Function(&Tokenizer, ParseTree); \
-                ParseTreeDeinit(ParseTree); \
-                GSTestAssert(Result == true, "Result should be true\n"); \
-                GSTestAssert(Tokenizer.At == (String) + GSStringLength((String)), "Tokenizer advances to end of string\n"); \
+                for (int mode = 0; mode < 2; mode++) { \
+                        ParseTreeNode *parse_tree = ParseTreeInit(&context.tree); \
+                        Tokenizer tokenizer = InitTokenizer((String), mode); \
+                        bool result = Function(&context, &tokenizer, parse_tree); \
+                        ParseTreeDeinit(&context.tree, parse_tree); \
+                        DeinitTokenizer(&tokenizer); \
+                        GSTestAssert(result == true, "Result should be true\n"); \
+                        GSTestAssert(tokenizer.at == (String) + gs_StringLength((String)), "Tokenizer advances to end of string\n"); \
+                } \
         }
 #define Reject(Function, String) \
         { \
-                parse_tree_node *ParseTree = ParseTreeInit(Allocator); \
-                struct tokenizer Tokenizer = InitTokenizer((String)); \
-                bool Result = Function(&Tokenizer, ParseTree); \
-                ParseTreeDeinit(ParseTree); \
-                GSTestAssert(Result != true, "Result should be false\n"); \
-                GSTestAssert(Tokenizer.At == (String), "Tokenizer doesn't advance\n"); \
+                for (int mode = 0; mode < 2; mode++) { \
+                        ParseTreeNode *parse_tree = ParseTreeInit(&context.tree); \
+                        Tokenizer tokenizer = InitTokenizer((String), mode); \
+                        bool result = Function(&context, &tokenizer, parse_tree); \
+                        ParseTreeDeinit(&context.tree, parse_tree); \
+                        DeinitTokenizer(&tokenizer); \
+                        GSTestAssert(result != true, "Result should be false\n"); \
+                        GSTestAssert(tokenizer.at == (String), "Tokenizer doesn't advance\n"); \
+                } \
         }
 
-struct tokenizer InitTokenizer(char *String) {
-        struct tokenizer Tokenizer;
-        Tokenizer.Beginning = Tokenizer.At = String;
-        Tokenizer.Line = Tokenizer.Column = 1;
-        return Tokenizer;
+Tokenizer InitTokenizer(char *string, bool pre_lexed) {
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, string);
+
+        if (pre_lexed) {
+                TokenStream *tokens = (TokenStream *)allocator.malloc(sizeof(*tokens));
+                LexTokenizerCompact(&context.lexer, &tokenizer, LexerEstimateTokens(string, gs_StringLength(string)), tokens);
+
+                TokenizerInit(&tokenizer, string);
+                TokenizerSetStream(&tokenizer, tokens);
+        }
+
+        return tokenizer;
+}
+
+void DeinitTokenizer(Tokenizer *tokenizer) {
+        if (tokenizer->tokens == GS_NULL_PTR) return;
+        TokenStreamDeinit(tokenizer->tokens);
+        allocator.free(tokenizer->tokens);
 }
 
 /*----------------------------------------------------------------------------
   Tests
   ----------------------------------------------------------------------------*/
 
+void AssertTokens(char *source, TokenType *types, int num_types) {
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, source);
+
+        for (int i = 0; i < num_types; i++) {
+                Token token = GetToken(&tokenizer);
+                GSTestAssert(token.type == types[i], "Token type matches\n");
+        }
+}
+
+void TestGetToken() {
+        {
+                TokenType types[] = {
+                        Token_DoubleLessThanEquals, Token_BitShiftLeft, Token_LessThanEqual, Token_LessThan,
+                        Token_Arrow, Token_MinusMinus, Token_MinusEquals, Token_Dash,
+                        Token_LogicalEqual, Token_EqualSign, Token_Ellipsis, Token_PrecisionNumber, Token_Dot,
+                        Token_DivideEquals, Token_Slash, Token_EndOfStream,
+                };
+                AssertTokens("<<= << <= < -> -- -= - == = ... .5 . /= /* comment */ /", types, gs_ArraySize(types));
+        }
+        {
+                TokenType types[] = {
+                        Token_KeywordInt, Token_Identifier, Token_Identifier, Token_Identifier, Token_Identifier,
+                        Token_Integer, Token_Integer, Token_Character, Token_String, Token_Hash, Token_EndOfStream,
+                };
+                AssertTokens("int integer doubled u l 0x1F 10u 'a' \"s\" #", types, gs_ArraySize(types));
+        }
+        {
+                TokenType types[] = {
+                        Token_KeywordAuto, Token_KeywordBreak, Token_KeywordCase, Token_KeywordChar,
+                        Token_KeywordConst, Token_KeywordContinue, Token_KeywordDefault, Token_KeywordDo,
+                        Token_KeywordDouble, Token_KeywordElse, Token_KeywordEnum, Token_KeywordExtern,
+                        Token_KeywordFloat, Token_KeywordFor, Token_KeywordGoto, Token_KeywordIf,
+                        Token_KeywordInt, Token_KeywordLong, Token_KeywordRegister, Token_KeywordReturn,
+                        Token_KeywordShort, Token_KeywordSigned, Token_KeywordSizeof, Token_KeywordStatic,
+                        Token_KeywordStruct, Token_KeywordSwitch, Token_KeywordTypedef, Token_KeywordUnion,
+                        Token_KeywordUnsigned, Token_KeywordVoid, Token_KeywordVolatile, Token_KeywordWhile,
+                        Token_Identifier, Token_Identifier, Token_Identifier, Token_Identifier, Token_EndOfStream,
+                };
+                AssertTokens("auto break case char const continue default do double else enum extern "
+                             "float for goto if int long register return short signed sizeof static "
+                             "struct switch typedef union unsigned void volatile while "
+                             "whilst fo volatiles _int",
+                             types, gs_ArraySize(types));
+        }
+        {
+                TokenType types[] = { Token_String, Token_Identifier, Token_String, Token_EndOfStream };
+                AssertTokens("/*/ still a comment */ \"ends in a backslash \\\\\" x \"quote \\\" inside\"", types, gs_ArraySize(types));
+        }
+        {
+                char *source = "/* a comment that is longer than one scanning block\n"
+                               " * and spans\n"
+                               " * three lines */    \t    \n"
+                               "        long_identifier";
+                Tokenizer tokenizer;
+                TokenizerInit(&tokenizer, source);
+
+                Token token = GetToken(&tokenizer);
+                GSTestAssert(token.type == Token_Identifier, "Comment and whitespace are skipped\n");
+
+                LexerLines lines;
+                u32 line, column;
+                GSTestAssert(LexerLinesInit(&lines, &context.lexer, source, gs_StringLength(source)), "Line index is built\n");
+                GSTestAssert(lines.num_breaks == 3, "Every line break is indexed\n");
+
+                LexerLinesFind(&lines, token.text, &line, &column);
+                GSTestAssert(line == 4 && column == 9, "Line and column are found after skipped text\n");
+                LexerLinesFind(&lines, source + 3, &line, &column);
+                GSTestAssert(line == 1 && column == 4, "Line and column are found on the first line\n");
+                LexerLinesFind(&lines, source + 52, &line, &column);
+                GSTestAssert(line == 2 && column == 1, "Line and column are found at the start of a line\n");
+                LexerLinesDeinit(&lines);
+        }
+        {
+                TokenType types[] = { Token_Identifier, Token_SemiColon, Token_EndOfStream };
+                AssertTokens("#include <stdio.h>\nx;", types, gs_ArraySize(types));
+        }
+        {
+                /* Longest match without spaces, backing up from `..' and an unterminated comment. */
+                TokenType types[] = {
+                        Token_Identifier, Token_Dot, Token_Dot, Token_Identifier, Token_DoubleGreaterThanEquals,
+                        Token_Identifier, Token_Arrow, Token_Identifier, Token_PlusPlus, Token_Cross,
+                        Token_Slash, Token_Asterisk, Token_Identifier, Token_EndOfStream,
+                };
+                AssertTokens("a..b>>=c->d+++/*x", types, gs_ArraySize(types));
+        }
+        {
+                Tokenizer tokenizer;
+                TokenizerInit(&tokenizer, "\x80@");
+                Token token = GetToken(&tokenizer);
+                GSTestAssert(token.type == Token_Unknown && token.text_length == 1, "Bytes outside the grammar are one unknown byte\n");
+                token = GetToken(&tokenizer);
+                GSTestAssert(token.type == Token_Unknown && token.text_length == 1, "Lexing continues after an unknown byte\n");
+        }
+}
+
+/* The compact stream must hold exactly what Lex produces. */
+void TestTokenStream() {
+        char *source = "int main(void) {\n\t/* skipped */ return sizeof(long) >> 2; /* */ }\n#define X \"s\"\n";
+
+        gs_Buffer buffer;
+        gs_BufferInit(&buffer, source, gs_StringLength(source));
+        buffer.length = buffer.capacity;
+
+        Token *tokens;
+        u32 num_tokens;
+        TokenStream stream;
+        GSTestAssert(Lex(&context.lexer, &buffer, &tokens, &num_tokens) == true, "Result should be true\n");
+        GSTestAssert(LexCompact(&context.lexer, &buffer, &stream) == true, "Result should be true\n");
+        GSTestAssert(stream.num_tokens == num_tokens, "Compact stream has every token\n");
+
+        for (u32 i = 0; i < num_tokens && i < stream.num_tokens; i++) {
+                Token token = TokenStreamGet(&stream, i);
+                GSTestAssert(token.type == tokens[i].type, "Token type matches\n");
+                GSTestAssert(token.text == tokens[i].text && token.text_length == tokens[i].text_length, "Token text matches\n");
+        }
+        GSTestAssert(stream.kind[stream.num_tokens - 1] == Token_EndOfStream, "Compact stream ends the input\n");
+
+        TokenStreamDeinit(&stream);
+        allocator.free(tokens);
+
+        /* Buffers grow past a size hint that is too small. */
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, source);
+        GSTestAssert(LexTokenizer(&context.lexer, &tokenizer, 1, &tokens, &num_tokens) == true, "Result should be true\n");
+        GSTestAssert(tokens[num_tokens - 1].type == Token_EndOfStream, "Growing buffer keeps every token\n");
+
+        TokenizerInit(&tokenizer, source);
+        GSTestAssert(LexTokenizerCompact(&context.lexer, &tokenizer, 1, &stream) == true, "Result should be true\n");
+        GSTestAssert(stream.num_tokens == num_tokens, "Growing compact stream keeps every token\n");
+
+        GSTestAssert(LexerEstimateTokens(source, gs_StringLength(source)) >= 14, "Estimate counts every run of non-whitespace\n");
+
+        TokenStreamDeinit(&stream);
+        allocator.free(tokens);
+}
+
+/*
+  Parallel lexing must match Lex even when chunks start inside comments,
+  strings and continued directives. The input is large enough for several
+  chunks, and the long comment swallows at least one whole chunk.
+*/
+void TestLexParallel() {
+        char *fragments[] = {
+                "int f(int a) { return a << 2; }\n",
+                "/* a comment with \"quotes\n and 'apostrophes and int x = 1;\n spanning lines */\n",
+                "char *s = \"/* not a comment\";\n",
+                "#define LONG(x) \\\n        ((x) + \\\n         1)\n",
+                "/*\n\"\n*/ x;\n",
+                "// a line comment is lexed as operators\n",
+        };
+        u64 capacity = 1024 * 1024;
+        char *source = (char *)allocator.malloc(capacity);
+        u64 length = 0;
+
+        for (u32 i = 0; length < capacity / 2; i++) {
+                char *fragment = fragments[i % gs_ArraySize(fragments)];
+                u32 fragment_length = gs_StringLength(fragment);
+                gs_MemCopy(fragment, source + length, fragment_length);
+                length += fragment_length;
+        }
+        source[length++] = '/';
+        source[length++] = '*';
+        for (; length < capacity * 3 / 4; length++) {
+                source[length] = (length % 61 == 0) ? '\n' : '"';
+        }
+        source[length++] = '*';
+        source[length++] = '/';
+        while (length < capacity - 64) {
+                char *fragment = fragments[length % gs_ArraySize(fragments)];
+                u32 fragment_length = gs_StringLength(fragment);
+                gs_MemCopy(fragment, source + length, fragment_length);
+                length += fragment_length;
+        }
+        source[length] = '\0';
+
+        gs_Buffer buffer;
+        gs_BufferInit(&buffer, source, length);
+        buffer.length = length;
+
+        Token *tokens, *parallel_tokens;
+        u32 num_tokens, num_parallel_tokens;
+        GSTestAssert(Lex(&context.lexer, &buffer, &tokens, &num_tokens) == true, "Result should be true\n");
+
+        u32 thread_counts[] = { 2, 5, 8 };
+        for (int t = 0; t < gs_ArraySize(thread_counts); t++) {
+                GSTestAssert(LexParallel(&context.lexer, &buffer, thread_counts[t], &parallel_tokens, &num_parallel_tokens) == true, "Result should be true\n");
+                GSTestAssert(num_parallel_tokens == num_tokens, "Parallel lexing finds every token\n");
+
+                bool same = true;
+                for (u32 i = 0; i < num_tokens && i < num_parallel_tokens; i++) {
+                        same = same && parallel_tokens[i].type == tokens[i].type && parallel_tokens[i].text == tokens[i].text &&
+                               parallel_tokens[i].text_length == tokens[i].text_length;
+                }
+                GSTestAssert(same, "Parallel lexing matches sequential lexing\n");
+                allocator.free(parallel_tokens);
+        }
+
+        allocator.free(tokens);
+        allocator.free(source);
+}
+
+/* Feeding input a few bytes at a time must give the same tokens as lexing it whole. */
+void TestLexerStream() {
+        char *source = "#include <stdio.h>\n"
+                       "#define TWO \\\n 2\n"
+                       "int main(void) { /* a comment\n spanning \"lines\" */\n"
+                       "        char *s = \"a \\\" string\"; char c = '\\'';\n"
+                       "        x <<= 12345; y = 1.5 ... z->w; w = 1.5e-3f + 0x1Fu .. a; /**/#define A \\\n B \n"
+                       "#define C /* not a comment start */\n"
+                       "        return identifier_at_the_end";
+
+        gs_Buffer buffer;
+        gs_BufferInit(&buffer, source, gs_StringLength(source));
+        buffer.length = buffer.capacity;
+
+        Token *tokens;
+        u32 num_tokens;
+        LexerLines lines;
+        GSTestAssert(Lex(&context.lexer, &buffer, &tokens, &num_tokens) == true, "Result should be true\n");
+        LexerLinesInit(&lines, &context.lexer, source, buffer.length);
+
+        for (u32 piece = 1; piece <= 7; piece++) {
+                LexerStream stream;
+                GSTestAssert(LexerStreamInit(&stream, &context.lexer) == true, "Result should be true\n");
+
+                u32 num_matching = 0, num_streamed = 0;
+                for (u64 fed = 0; fed < buffer.length + piece; fed += piece) {
+                        if (fed < buffer.length) {
+                                LexerStreamFeed(&stream, source + fed, gs_Min(piece, buffer.length - fed));
+                        } else {
+                                LexerStreamFinish(&stream);
+                        }
+
+                        Token token;
+                        while (num_streamed < num_tokens && LexerStreamNext(&stream, &token)) {
+                                Token expected = tokens[num_streamed++];
+                                u32 line, column, expected_line, expected_column;
+                                LexerStreamPosition(&stream, token, &line, &column);
+                                LexerLinesFind(&lines, expected.text, &expected_line, &expected_column);
+
+                                if (token.type == expected.type && token.text_length == expected.text_length &&
+                                    LexerStreamTokenOffset(&stream, token) == (u64)(expected.text - source) &&
+                                    line == expected_line && column == expected_column) {
+                                        num_matching++;
+                                }
+                        }
+                }
+
+                GSTestAssert(num_streamed == num_tokens, "Streaming finds every token\n");
+                GSTestAssert(num_matching == num_tokens, "Streamed tokens match lexing the whole input\n");
+                LexerStreamDeinit(&stream);
+        }
+
+        LexerLinesDeinit(&lines);
+        allocator.free(tokens);
+}
+
+/* Counts the tokens the stream hands out as it stands, up to and including the end of the stream. */
+u32 DrainLexerStream(LexerStream *stream) {
+        Token token;
+        u32 num_tokens = 0;
+        while (LexerStreamNext(stream, &token)) {
+                num_tokens++;
+                if (token.type == Token_EndOfStream) break;
+        }
+        return num_tokens;
+}
+
+/* Tokens come out without waiting for a line break, and open comments aren't scanned again from their start. */
+void TestLexerStreamOneLine() {
+        LexerStream stream;
+        GSTestAssert(LexerStreamInit(&stream, &context.lexer) == true, "Result should be true\n");
+        char *line = "x = a+b; y = c";
+        LexerStreamFeed(&stream, line, gs_StringLength(line));
+        GSTestAssert(DrainLexerStream(&stream) == 8, "Every token but the last is final\n");
+        LexerStreamFinish(&stream);
+        GSTestAssert(DrainLexerStream(&stream) == 2, "The last token and the end follow on finishing\n");
+        LexerStreamDeinit(&stream);
+
+        /* A long line, drained as it arrives, never needs more than the first buffer. */
+        GSTestAssert(LexerStreamInit(&stream, &context.lexer) == true, "Result should be true\n");
+        char *piece = "a=b;a=b;a=b;a=b;a=b;a=b;a=b;a=b;";
+        u32 num_pieces = 1 << 15, num_tokens = 0;
+        for (u32 i = 0; i < num_pieces; i++) {
+                LexerStreamFeed(&stream, piece, gs_StringLength(piece));
+                num_tokens += DrainLexerStream(&stream);
+        }
+        GSTestAssert(num_tokens == num_pieces * 32, "Every token is final once the next arrives\n");
+        GSTestAssert(stream.capacity == LEXER_DEFAULT_CAPACITY, "Handed out input isn't kept\n");
+        LexerStreamDeinit(&stream);
+
+        /* A byte at a time; scanning the comment from its start on each feed takes minutes. */
+        GSTestAssert(LexerStreamInit(&stream, &context.lexer) == true, "Result should be true\n");
+        LexerStreamFeed(&stream, "/*", 2);
+        for (u32 i = 0; i < (1 << 18); i++) {
+                LexerStreamFeed(&stream, (i % 64 == 0) ? "\n" : "*", 1);
+                GSTestAssert(DrainLexerStream(&stream) == 0, "Nothing is final inside a comment\n");
+        }
+        LexerStreamFeed(&stream, "/ z", 3);
+        LexerStreamFinish(&stream);
+        Token token;
+        GSTestAssert(LexerStreamNext(&stream, &token) == true && token.type == Token_Identifier, "The comment is skipped\n");
+        GSTestAssert(LexerStreamTokenOffset(&stream, token) == 2 + (1 << 18) + 2, "Offsets count the comment\n");
+        LexerStreamDeinit(&stream);
+}
+
+/* Lexes `source' into a compact stream, recovering from errors if `diagnostics' is set. */
+bool LexCompactSource(char *source, LexerDiagnostics *diagnostics, TokenStream *out_stream) {
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, source);
+        if (diagnostics != NULL) {
+                LexerDiagnosticsClear(diagnostics);
+                TokenizerSetDiagnostics(&tokenizer, diagnostics);
+        }
+        return LexTokenizerCompact(&context.lexer, &tokenizer, 0, out_stream);
+}
+
+/*
+  Makes random edits to `initial', re-lexing after each, and counts the edits
+  after which the stream matches lexing the edited source from scratch.
+*/
+u32 CountMatchingLexEdits(char *initial, u32 num_edits, LexerDiagnostics *diagnostics) {
+        char *pieces[] = { "/*", "*/", "\"", "'", "x", "1", ".", "=", "<", " ", "\n", "#", "\\", "int", "\n#define Y 2\n", "@", "9z" };
+
+        u32 capacity = 4096;
+        char *source = (char *)allocator.malloc(capacity);
+        u32 length = gs_StringLength(initial);
+        gs_MemCopy(initial, source, length + 1);
+
+        TokenStream stream;
+        GSTestAssert(LexCompactSource(source, diagnostics, &stream) == true, "Result should be true\n");
+
+        u32 seed = 12345;
+        u32 num_matching = 0;
+        for (u32 edit = 0; edit < num_edits; edit++) {
+                seed = seed * 1103515245 + 12345;
+                u32 offset = (seed >> 8) % (length + 1);
+                seed = seed * 1103515245 + 12345;
+                u32 removed = gs_Min((seed >> 8) % 4, length - offset);
+                seed = seed * 1103515245 + 12345;
+                char *inserted = pieces[(seed >> 8) % gs_ArraySize(pieces)];
+                u32 inserted_length = (edit % 3 == 0) ? 0 : gs_StringLength(inserted);
+                if (length - removed + inserted_length >= capacity) inserted_length = 0;
+
+                /* Shift the tail, including the NUL, then write the inserted text. */
+                char *tail = source + offset + removed;
+                char *moved_tail = source + offset + inserted_length;
+                u32 tail_length = length - offset - removed + 1;
+                if (moved_tail > tail) {
+                        for (u32 i = tail_length; i-- > 0;) moved_tail[i] = tail[i];
+                } else {
+                        for (u32 i = 0; i < tail_length; i++) moved_tail[i] = tail[i];
+                }
+                gs_MemCopy(inserted, source + offset, inserted_length);
+                length = length - removed + inserted_length;
+
+                GSTestAssert(LexEdit(&stream, source, offset, removed, inserted_length) == true, "Result should be true\n");
+
+                TokenStream expected;
+                LexCompactSource(source, diagnostics, &expected);
+
+                bool same = (stream.num_tokens == expected.num_tokens);
+                for (u32 i = 0; same && i < expected.num_tokens; i++) {
+                        same = stream.kind[i] == expected.kind[i] && stream.offset[i] == expected.offset[i] &&
+                               stream.length[i] == expected.length[i] && stream.payload[i] == expected.payload[i];
+                }
+                same = same && stream.num_values == expected.num_values;
+                for (u32 i = 0; same && i < expected.num_values; i++) {
+                        same = stream.value_token[i] == expected.value_token[i] &&
+                               stream.value[i].as.integer == expected.value[i].as.integer;
+                }
+                if (same) num_matching++;
+                TokenStreamDeinit(&expected);
+        }
+
+        TokenStreamDeinit(&stream);
+        allocator.free(source);
+        return num_matching;
+}
+
+/* Re-lexing after each edit must give the same stream as lexing the edited source from scratch. */
+void TestLexEdit() {
+        char *initial = "int main(void) {\n"
+                        "        /* comment */ char *s = \"str\"; char c = 'c';\n"
+                        "#define X(a) \\\n        ((a) << 2)\n"
+                        "        return x <<= 1 ... y->z;\n"
+                        "}\n";
+        GSTestAssert(CountMatchingLexEdits(initial, 1000, NULL) == 1000, "Edited stream matches lexing from scratch\n");
+
+        /* With recovery, error tokens come anywhere in the stream and lexing goes on past them. */
+        char *broken = "int main(void) {\n"
+                       "        char *s = \"open; int @@ y = 12ab + 'xyz';\n"
+                       "        /* comment */ char c = 'c'; ` z = \"str\";\n"
+                       "        return x <<= 1 ... y->z;\n"
+                       "}\n";
+        LexerDiagnostics diagnostics;
+        GSTestAssert(LexerDiagnosticsInit(&diagnostics, &context.lexer, 16) == true, "Result should be true\n");
+        GSTestAssert(CountMatchingLexEdits(broken, 3000, &diagnostics) == 3000, "Edited recovering stream matches lexing from scratch\n");
+        LexerDiagnosticsDeinit(&diagnostics);
+
+        /* A stream without constants has no side table; editing it mustn't touch one. */
+        gs_Buffer buffer;
+        TokenStream stream;
+        char plain[] = "a = b; c = d;\0\0";
+        gs_BufferInit(&buffer, plain, gs_StringLength(plain));
+        buffer.length = buffer.capacity;
+        GSTestAssert(LexCompact(&context.lexer, &buffer, &stream) == true, "Result should be true\n");
+        gs_MemCopy("a = bb; c = d;", plain, 15);
+        GSTestAssert(LexEdit(&stream, plain, 5, 0, 1) == true, "Result should be true\n");
+        GSTestAssert(stream.num_tokens == 9 && stream.num_values == 0 && stream.length[2] == 2 && stream.offset[4] == 8,
+                     "Edited stream without constants is spliced\n");
+        TokenStreamDeinit(&stream);
+}
+
+/* Identifiers get dense symbols, stable across lexes that share a table. */
+void TestLexerSymbols() {
+        LexerSymbols symbols;
+        GSTestAssert(LexerSymbolsInit(&symbols, allocator) == true, "Result should be true\n");
+
+        char *source = "int count = count_max - count; struct count *next;";
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, source);
+        TokenizerSetSymbols(&tokenizer, &symbols);
+
+        TokenStream stream;
+        GSTestAssert(LexTokenizerCompact(&context.lexer, &tokenizer, 0, &stream) == true, "Result should be true\n");
+        GSTestAssert(stream.symbols == &symbols, "Stream records its symbol table\n");
+        GSTestAssert(symbols.num_symbols == 3, "Each distinct identifier is interned once\n");
+
+        u32 count = LexerSymbolsFind(&symbols, "count", 5);
+        GSTestAssert(count == 0, "Symbols are numbered in order of appearance\n");
+        GSTestAssert(LexerSymbolsFind(&symbols, "count_max", 9) == 1, "Symbols are dense\n");
+        GSTestAssert(LexerSymbolsFind(&symbols, "coun", 4) == LEXER_NO_SYMBOL, "A prefix is a different name\n");
+        GSTestAssert(gs_StringIsEqual(LexerSymbolsName(&symbols, 2, GS_NULL_PTR), "next", 5), "Symbol names are kept\n");
+
+        u32 num_count = 0;
+        for (u32 i = 0; i < stream.num_tokens; i++) {
+                Token token = TokenStreamGet(&stream, i);
+                if (token.type == Token_Identifier) {
+                        if (token.symbol == count) num_count++;
+                } else {
+                        GSTestAssert(token.symbol == LEXER_NO_SYMBOL, "Only identifiers have symbols\n");
+                }
+        }
+        GSTestAssert(num_count == 3, "Every use of a name has its symbol\n");
+        TokenStreamDeinit(&stream);
+
+        /* A second file reuses the table. */
+        TokenizerInit(&tokenizer, "next = count;");
+        TokenizerSetSymbols(&tokenizer, &symbols);
+        GSTestAssert(GetToken(&tokenizer).symbol == 2, "Symbols are stable across lexes\n");
+        GetToken(&tokenizer);
+        GSTestAssert(GetToken(&tokenizer).symbol == count, "Symbols are stable across lexes\n");
+        GSTestAssert(symbols.num_symbols == 3, "Known names aren't interned again\n");
+
+        /* Enough names to grow the table. */
+        char name[16];
+        for (u32 i = 0; i < 5000; i++) {
+                u32 length = (u32)snprintf(name, sizeof(name), "name_%u", i);
+                LexerSymbolsIntern(&symbols, name, length);
+        }
+        GSTestAssert(symbols.num_symbols == 5003, "Table grows\n");
+        GSTestAssert(LexerSymbolsFind(&symbols, "name_4321", 9) == 3 + 4321, "Growing keeps every symbol\n");
+        GSTestAssert(LexerSymbolsFind(&symbols, "count", 5) == count, "Growing keeps every symbol\n");
+
+        LexerSymbolsDeinit(&symbols);
+
+        /* Typedef names are matched whole, not by prefix. */
+        TypedefInit(&context);
+        TypedefAddName(&context, "my_type");
+        Tokenizer typedef_tokenizer = InitTokenizer("my my_type my_type_t", false);
+        GSTestAssert(TypedefIsName(&context, GetToken(&typedef_tokenizer)) == false, "A prefix isn't a typedef name\n");
+        GSTestAssert(TypedefIsName(&context, GetToken(&typedef_tokenizer)) == true, "Typedef name is found\n");
+        GSTestAssert(TypedefIsName(&context, GetToken(&typedef_tokenizer)) == false, "A longer name isn't a typedef name\n");
+        TypedefClear(&context);
+}
+
+/* The integer-constants data file, checked against the C library's conversion. */
+void TestIntegerConstantsFile() {
+        FILE *file = fopen("data/integer-constants.txt", "r");
+        GSTestAssert(file != NULL, "Integer constants file opens\n");
+        if (file == NULL) return;
+
+        static const struct { char *suffix; LexerValueType type; } suffixes[] = {
+                { "", LexerValue_Int }, { "u", LexerValue_UnsignedInt }, { "U", LexerValue_UnsignedInt },
+                { "l", LexerValue_Long }, { "L", LexerValue_Long },
+        };
+
+        char line[128];
+        u32 num_checked = 0;
+        while (fgets(line, sizeof(line), file) != NULL) {
+                u32 length = gs_StringLength(line);
+                while (length > 0 && gs_CharIsWhitespace(line[length - 1])) line[--length] = '\0';
+                if (length == 0) continue;
+
+                char *end;
+                u64 expected = strtoull(line, &end, 0);
+                i32 suffix = -1;
+                for (u32 i = 0; i < gs_ArraySize(suffixes); i++) {
+                        if (strcmp(end, suffixes[i].suffix) == 0) suffix = i;
+                }
+
+                Tokenizer tokenizer;
+                TokenizerInit(&tokenizer, line);
+                Token token = GetToken(&tokenizer);
+                bool whole = (token.type == Token_Integer && token.text_length == length);
+                if (suffix < 0) {
+                        GSTestAssert(!whole, "Malformed constant is rejected\n");
+                        continue;
+                }
+
+                LexerValue value;
+                GSTestAssert(whole && LexerDecodeConstant(token, &value), "Constant lexes whole\n");
+                GSTestAssert(value.as.integer == expected && !value.overflow, "Constant value matches strtoull\n");
+                GSTestAssert(value.type == suffixes[suffix].type, "Constant type follows its suffix\n");
+                u32 radix = (line[0] != '0' || length == 1) ? 10 : (line[1] == 'x' || line[1] == 'X') ? 16 : 8;
+                GSTestAssert(value.radix == radix, "Constant radix follows its prefix\n");
+                num_checked++;
+        }
+        GSTestAssert(num_checked == 30, "Every well-formed constant is checked\n");
+
+        fclose(file);
+}
+
+void AssertConstant(char *text, TokenType token_type, LexerValueType type, u64 integer, f64 floating) {
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, text);
+        Token token = GetToken(&tokenizer);
+        LexerValue value;
+
+        GSTestAssert(token.type == token_type && token.text_length == gs_StringLength(text), "Constant lexes whole\n");
+        GSTestAssert(LexerDecodeConstant(token, &value) == true, "Constant decodes\n");
+        GSTestAssert(value.type == type, "Constant has the type C gives it\n");
+        if (token_type == Token_PrecisionNumber) {
+                GSTestAssert(value.as.floating == floating, "Floating constant has the nearest value\n");
+        } else {
+                GSTestAssert(value.as.integer == integer, "Constant has its value\n");
+        }
+}
+
+void TestLexerValues() {
+        TestIntegerConstantsFile();
+
+        AssertConstant("0x10ULL", Token_Integer, LexerValue_UnsignedLongLong, 16, 0);
+        AssertConstant("077lu", Token_Integer, LexerValue_UnsignedLong, 63, 0);
+        AssertConstant("42ll", Token_Integer, LexerValue_LongLong, 42, 0);
+        AssertConstant("1234567890123456789", Token_Integer, LexerValue_Long, 1234567890123456789ull, 0);
+        AssertConstant("18446744073709551615u", Token_Integer, LexerValue_UnsignedLong, 18446744073709551615ull, 0);
+        AssertConstant("0xFFFFFFFFFFFFFFFF", Token_Integer, LexerValue_UnsignedLong, 18446744073709551615ull, 0);
+
+        /* Unsuffixed and suffixed constants widen to the first type that holds them. */
+        AssertConstant("2147483647", Token_Integer, LexerValue_Int, 2147483647, 0);
+        AssertConstant("2147483648", Token_Integer, LexerValue_Long, 2147483648ull, 0);
+        AssertConstant("0x7FFFFFFF", Token_Integer, LexerValue_Int, 0x7FFFFFFF, 0);
+        AssertConstant("0x80000000", Token_Integer, LexerValue_UnsignedInt, 0x80000000ull, 0);
+        AssertConstant("037777777777", Token_Integer, LexerValue_UnsignedInt, 0xFFFFFFFFull, 0);
+        AssertConstant("0x100000000", Token_Integer, LexerValue_Long, 0x100000000ull, 0);
+        AssertConstant("4294967296u", Token_Integer, LexerValue_UnsignedLong, 4294967296ull, 0);
+        AssertConstant("0x8000000000000000l", Token_Integer, LexerValue_UnsignedLong, 0x8000000000000000ull, 0);
+        AssertConstant("0x8000000000000000ll", Token_Integer, LexerValue_UnsignedLongLong, 0x8000000000000000ull, 0);
+        AssertConstant("1.5f", Token_PrecisionNumber, LexerValue_Float, 0, 1.5);
+        AssertConstant(".125L", Token_PrecisionNumber, LexerValue_LongDouble, 0, 0.125);
+        AssertConstant("0.1", Token_PrecisionNumber, LexerValue_Double, 0, 0.1);
+        AssertConstant("2.5e-3", Token_PrecisionNumber, LexerValue_Double, 0, 2.5e-3);
+        AssertConstant("6.02e23", Token_PrecisionNumber, LexerValue_Double, 0, 6.02e23);
+        AssertConstant("3.14159265358979323846264338", Token_PrecisionNumber, LexerValue_Double, 0, 3.14159265358979323846264338);
+        AssertConstant("'a'", Token_Character, LexerValue_Character, 'a', 0);
+        AssertConstant("'\\n'", Token_Character, LexerValue_Character, '\n', 0);
+        AssertConstant("'\\''", Token_Character, LexerValue_Character, '\'', 0);
+        AssertConstant("'\\0'", Token_Character, LexerValue_Character, 0, 0);
+
+        Tokenizer tokenizer;
+        LexerValue value;
+        TokenizerInit(&tokenizer, "18446744073709551616");
+        GSTestAssert(LexerDecodeConstant(GetToken(&tokenizer), &value) && value.overflow, "Overflow is flagged\n");
+        GSTestAssert(value.as.integer == 0, "An overflowing constant keeps its low 64 bits\n");
+        TokenizerInit(&tokenizer, "123456789012345678901");
+        GSTestAssert(LexerDecodeConstant(GetToken(&tokenizer), &value) && value.overflow, "Overflow past 20 digits is flagged\n");
+        GSTestAssert(value.as.integer == 12776324570088369205ull, "It keeps its low 64 bits\n");
+        TokenizerInit(&tokenizer, "10000000000000000000000000000000000000007");
+        GSTestAssert(LexerDecodeConstant(GetToken(&tokenizer), &value) && value.overflow, "Overflow past 40 digits is flagged\n");
+        GSTestAssert(value.as.integer == 13399722918938673159ull, "It keeps its low 64 bits\n");
+        TokenizerInit(&tokenizer, "9223372036854775808");
+        GSTestAssert(LexerDecodeConstant(GetToken(&tokenizer), &value) && value.overflow, "A decimal constant past long long is flagged\n");
+        GSTestAssert(value.type == LexerValue_LongLong && value.as.integer == 9223372036854775808ull, "It keeps its value and widest type\n");
+        TokenizerInit(&tokenizer, "0x10000000000000000");
+        GSTestAssert(LexerDecodeConstant(GetToken(&tokenizer), &value) && value.overflow, "A hexadecimal constant past 64 bits is flagged\n");
+        GSTestAssert(value.type == LexerValue_UnsignedLongLong, "It has the widest type\n");
+        TokenizerInit(&tokenizer, "1lL");
+        GSTestAssert(GetToken(&tokenizer).type == Token_Unknown, "Mixed-case ll is rejected\n");
+        TokenizerInit(&tokenizer, "1uu");
+        GSTestAssert(GetToken(&tokenizer).type == Token_Unknown, "Repeated u is rejected\n");
+
+        /* The compact stream carries every constant's value in its side table. */
+        char *source = "x = 0x1F + 'a' * 2.5 - y;";
+        TokenizerInit(&tokenizer, source);
+        TokenStream stream;
+        GSTestAssert(LexTokenizerCompact(&context.lexer, &tokenizer, 0, &stream) == true, "Result should be true\n");
+        GSTestAssert(stream.num_values == 3, "Side table holds only constants\n");
+        GSTestAssert(TokenStreamValue(&stream, 2, &value) && value.as.integer == 31 && value.radix == 16, "Integer value is in the side table\n");
+        GSTestAssert(TokenStreamValue(&stream, 4, &value) && value.as.integer == 'a', "Character value is in the side table\n");
+        GSTestAssert(TokenStreamValue(&stream, 6, &value) && value.as.floating == 2.5, "Floating value is in the side table\n");
+        GSTestAssert(TokenStreamValue(&stream, 0, &value) == false, "Identifiers have no value\n");
+        TokenStreamDeinit(&stream);
+}
+
+/* Comments and directives are skipped without recursion, and recorded on request. */
+void TestLexerTrivia() {
+        char *source = "/* a */ int x; // no\n#define Y 1\n/* b */\n/* c */ y\n/* end */";
+        LexerTrivia trivia;
+        LexerTriviaInit(&trivia, allocator);
+
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, source);
+        TokenizerSetTrivia(&tokenizer, &trivia);
+        GSTestAssert(PeekToken(&tokenizer).type == Token_KeywordInt, "Peek skips trivia\n");
+        GSTestAssert(trivia.num_trivia == 0, "Peeking records nothing\n");
+
+        TokenStream stream;
+        GSTestAssert(LexTokenizerCompact(&context.lexer, &tokenizer, 0, &stream) == true, "Result should be true\n");
+        GSTestAssert(trivia.num_trivia == 5, "Every comment and directive is recorded\n");
+        GSTestAssert(trivia.kind[0] == Token_Comment && trivia.offset[0] == 0 && trivia.length[0] == 7, "Comment is recorded\n");
+        GSTestAssert(trivia.kind[1] == Token_PreprocessorCommand && gs_StringIsEqual(source + trivia.offset[1], "#define Y 1", trivia.length[1]),
+                     "Directive is recorded\n");
+
+        /* Tokens: int x ; / / no y <end>. */
+        u32 first;
+        GSTestAssert(LexerTriviaFind(&trivia, stream.offset[0], &first) == 1 && first == 0, "Leading comment belongs to the first token\n");
+        GSTestAssert(LexerTriviaFind(&trivia, stream.offset[1], &first) == 0, "Tokens without trivia have none\n");
+        GSTestAssert(LexerTriviaFind(&trivia, stream.offset[6], &first) == 3 && first == 1, "Trivia runs belong to the next token\n");
+        GSTestAssert(LexerTriviaFind(&trivia, stream.offset[7], &first) == 1 && first == 4, "Trailing comment belongs to the end of the stream\n");
+        TokenStreamDeinit(&stream);
+        LexerTriviaDeinit(&trivia);
+
+        /* A long run of comments and directives doesn't grow the stack. */
+        u32 num_lines = 200000;
+        char *lines = (char *)allocator.malloc(num_lines * 8 + 2);
+        for (u32 i = 0; i < num_lines; i++) gs_MemCopy((i % 2) ? "/* c */\n" : "#line 1\n", lines + i * 8, 8);
+        gs_MemCopy("x", lines + num_lines * 8, 2);
+
+        TokenizerInit(&tokenizer, lines);
+        Token token = GetToken(&tokenizer);
+        GSTestAssert(token.type == Token_Identifier && token.text == lines + num_lines * 8, "Every line is skipped\n");
+        allocator.free(lines);
+}
+
+void TestLexerDiagnostics() {
+        char *source = "a @@ 09 b 'xy\nc \"d";
+        LexerDiagnostics diagnostics;
+        GSTestAssert(LexerDiagnosticsInit(&diagnostics, &context.lexer, 2) == true, "Diagnostics are allocated\n");
+
+        gs_Buffer buffer;
+        gs_BufferInit(&buffer, source, gs_StringLength(source));
+        buffer.length = buffer.capacity;
+        Token *tokens;
+        u32 num_tokens;
+        GSTestAssert(LexWithDiagnostics(&context.lexer, &buffer, &diagnostics, &tokens, &num_tokens) == true, "Result should be true\n");
+
+        /* Tokens: a @@ 09 b 'xy c "d <end>. */
+        GSTestAssert(num_tokens == 8 && tokens[num_tokens - 1].type == Token_EndOfStream, "Lexing goes on to the end\n");
+        GSTestAssert(tokens[1].type == Token_Unknown && tokens[1].text_length == 2, "A run of stray bytes is one error token\n");
+        GSTestAssert(tokens[2].type == Token_Unknown && tokens[2].text_length == 2, "A bad number is one error token\n");
+        GSTestAssert(tokens[4].type == Token_Unknown && tokens[4].text_length == 3, "A bad character constant ends at the line\n");
+        GSTestAssert(tokens[6].type == Token_Unknown && tokens[6].text_length == 2, "An unterminated string is one error token\n");
+
+        GSTestAssert(diagnostics.num_entries == 2 && diagnostics.num_dropped == 2, "Errors past capacity are only counted\n");
+        GSTestAssert(diagnostics.entries[0].kind == LexerDiagnostic_StrayCharacter && diagnostics.entries[0].offset == 2 &&
+                     diagnostics.entries[0].length == 2, "Stray bytes are recorded\n");
+        GSTestAssert(diagnostics.entries[1].kind == LexerDiagnostic_BadNumber && diagnostics.entries[1].offset == 5,
+                     "A bad number is recorded\n");
+        allocator.free(tokens);
+
+        /* Peeking widens the error the same way but leaves recording to the take. */
+        LexerDiagnosticsClear(&diagnostics);
+        Tokenizer tokenizer;
+        TokenizerInit(&tokenizer, "\"never closed");
+        TokenizerSetDiagnostics(&tokenizer, &diagnostics);
+        GSTestAssert(PeekToken(&tokenizer).text_length == 13, "Peek widens the error\n");
+        GSTestAssert(diagnostics.num_entries == 0, "Peeking records nothing\n");
+
+        TokenStream stream;
+        GSTestAssert(LexTokenizerCompact(&context.lexer, &tokenizer, 0, &stream) == true, "Result should be true\n");
+        GSTestAssert(stream.num_tokens == 2 && stream.length[0] == 13, "The compact stream goes on past errors\n");
+        GSTestAssert(diagnostics.num_entries == 1 && diagnostics.entries[0].kind == LexerDiagnostic_UnterminatedString,
+                     "An unterminated string is recorded\n");
+        TokenStreamDeinit(&stream);
+        LexerDiagnosticsDeinit(&diagnostics);
+
+        /* Without diagnostics, lexing still stops at the first error. */
+        GSTestAssert(Lex(&context.lexer, &buffer, &tokens, &num_tokens) == true, "Result should be true\n");
+        GSTestAssert(num_tokens == 2 && tokens[1].type == Token_Unknown && tokens[1].text_length == 1, "Lex stops at the first error\n");
+        LexerErrorString(&context.lexer);
+        allocator.free(tokens);
+}
+
 void TestConstant() {
         parser_function Fn = ParseConstant;
         Accept(Fn, "1");   /* integer-constant */
@@ -111,6 +829,11 @@ void TestCastExpression() {
         parser_function Fn = ParseCastExpression;
         Accept(Fn, "sizeof(int)"); /* unary-expression */
         Accept(Fn, "(int)4.0");    /* ( type-name ) cast-expression */
+        Accept(Fn, "(Foo)");       /* ( expression ) */
+        TypedefInit(&context);
+        TypedefAddName(&context, "my_type");
+        Accept(Fn, "(my_type)4.0"); /* ( typedef-name ) cast-expression */
+        TypedefClear(&context);
 }
 
 void TestMultiplicativeExpression() {
@@ -271,6 +994,9 @@ void TestExpressionStatement() {
         Accept(Fn, "++Foo |= (2 || 3 ? 4 : 5) ;");
         Accept(Fn, "++Foo, Foo++;");
         Accept(Fn, "i=0;");
+        Accept(Fn, "a = b - c - d * e + f;");
+        Reject(Fn, "a + ;");
+        Reject(Fn, "a ? b ;");
 }
 
 void TestLabeledStatement() {
@@ -288,15 +1014,18 @@ void TestStatement() {
         Accept(Fn, "switch(Foo) { break; }");           /* selection-statement */
         Accept(Fn, "for(i=0; i<Foo; i++) { ; }");       /* iteration-statement */
         Accept(Fn, "goto foo;");                        /* jump-statement */
+        Accept(Fn, "foo: bar();");                      /* identifier : statement */
+        Accept(Fn, "foo;");                             /* expression-statement */
+        Reject(Fn, "else;");
 }
 
 void TestTypedefName() {
         parser_function Fn = ParseTypedefName;
         Reject(Fn, "my_type");
-        TypedefInit();
-        TypedefAddName("my_type");
+        TypedefInit(&context);
+        TypedefAddName(&context, "my_type");
         Accept(Fn, "my_type"); /* identifier */
-        TypedefClear();
+        TypedefClear(&context);
 }
 
 void TestDirectAbstractDeclarator() {
@@ -327,11 +1056,11 @@ void TestTypeName() {
         Accept(Fn, "const void");   /* specifier-qualifier-list abstract-declarator(opt) */
         Accept(Fn, "short");
         Reject(Fn, "my_type");
-        TypedefInit();
-        TypedefAddName("my_type");
+        TypedefInit(&context);
+        TypedefAddName(&context, "my_type");
         Accept(Fn, "my_type");
         Accept(Fn, "const my_type");
-        TypedefClear();
+        TypedefClear(&context);
 }
 
 void TestInitializerList() {
@@ -551,6 +1280,10 @@ void TestExternalDeclaration() {
         parser_function Fn = ParseExternalDeclaration;
         Accept(Fn, "main() {}");                   /* function-definition */
         Accept(Fn, "const volatile int foo = 2;"); /* declaration */
+        Accept(Fn, "int f(a, b) int a; char *b; { }");
+        Accept(Fn, "int f(int), *p, x = 1;");
+        Reject(Fn, "foo;");
+        Reject(Fn, "int f() 2;");
 }
 
 void TestTranslationUnit() {
@@ -559,22 +1292,466 @@ void TestTranslationUnit() {
         Accept(Fn, "int main(int argc, char **argv) { int i = 2; return(i); }");
 }
 
+bool TreesMatch(ParseTreeNode *a, ParseTreeNode *b) {
+        if (a == GS_NULL_PTR || b == GS_NULL_PTR) return a == b;
+        if (a->type != b->type || a->token.type != b->token.type || a->token.text != b->token.text) return false;
+
+        ParseTreeNode *a_child = (a->tree.child == GS_NULL_PTR) ? GS_NULL_PTR : gs_TreeContainer(a->tree.child, ParseTreeNode, tree);
+        ParseTreeNode *b_child = (b->tree.child == GS_NULL_PTR) ? GS_NULL_PTR : gs_TreeContainer(b->tree.child, ParseTreeNode, tree);
+        ParseTreeNode *a_sibling = (a->tree.sibling == GS_NULL_PTR) ? GS_NULL_PTR : gs_TreeContainer(a->tree.sibling, ParseTreeNode, tree);
+        ParseTreeNode *b_sibling = (b->tree.sibling == GS_NULL_PTR) ? GS_NULL_PTR : gs_TreeContainer(b->tree.sibling, ParseTreeNode, tree);
+
+        return TreesMatch(a_child, b_child) && TreesMatch(a_sibling, b_sibling);
+}
+
+void TestArena() {
+        gs_Arena arena;
+        gs_ArenaInit(&arena, allocator, 64);
+
+        u32 *first = (u32 *)gs_ArenaAlloc(&arena, sizeof(u32) * 4);
+        for (int i = 0; i < 4; i++) first[i] = i + 1;
+
+        void *large = gs_ArenaAlloc(&arena, 1000);
+        GSTestAssert(large != GS_NULL_PTR, "Allocations larger than a block succeed\n");
+        GSTestAssert(((u64)large & 7) == 0, "Allocations are 8-byte aligned\n");
+
+        u32 *grown = (u32 *)gs_ArenaRealloc(&arena, first, sizeof(u32) * 8);
+        GSTestAssert(grown[0] == 1 && grown[3] == 4, "Realloc keeps the old contents\n");
+        GSTestAssert(gs_ArenaOwns(&arena, grown) && gs_ArenaOwns(&arena, large), "Arena owns its allocations\n");
+        GSTestAssert(!gs_ArenaOwns(&arena, &arena), "Arena doesn't own foreign memory\n");
+
+        gs_ArenaMark mark = gs_ArenaGetMark(&arena);
+        void *speculative = gs_ArenaAlloc(&arena, 16);
+        gs_ArenaAlloc(&arena, 500);
+        gs_ArenaRollback(&arena, mark);
+        GSTestAssert(!gs_ArenaOwns(&arena, speculative), "Rollback releases allocations made after the mark\n");
+        GSTestAssert(gs_ArenaOwns(&arena, grown), "Rollback keeps allocations made before the mark\n");
+        GSTestAssert(gs_ArenaAlloc(&arena, 16) == speculative, "Rollback reuses the released space\n");
+
+        gs_ArenaDeinit(&arena);
+        GSTestAssert(!gs_ArenaOwns(&arena, grown), "Deinit releases every block\n");
+}
+
+void TestTreeChildren() {
+        ParseTreeNode *parent = ParseTreeInit(&context.tree);
+        ParseTreeNode *children[4];
+        for (int i = 0; i < 4; i++) {
+                children[i] = ParseTreeAddChild(&context.tree, parent);
+        }
+
+        GSTestAssert(gs_TreeNumChildren(&parent->tree) == 4, "Appends are counted\n");
+        GSTestAssert(gs_TreeChildAt(parent, ParseTreeNode, tree, 0) == children[0], "First child is at 0\n");
+        GSTestAssert(gs_TreeChildAt(parent, ParseTreeNode, tree, 3) == children[3], "Last child is at 3\n");
+
+        GSTestAssert(ParseTreeRemoveChild(&context.tree, parent, children[3]), "Last child is removed\n");
+        GSTestAssert(ParseTreeRemoveChild(&context.tree, parent, children[0]), "First child is removed\n");
+        GSTestAssert(gs_TreeNumChildren(&parent->tree) == 2, "Removals are counted\n");
+
+        ParseTreeNode *appended = ParseTreeAddChild(&context.tree, parent);
+        GSTestAssert(gs_TreeChildAt(parent, ParseTreeNode, tree, 0) == children[1], "Order is kept\n");
+        GSTestAssert(gs_TreeChildAt(parent, ParseTreeNode, tree, 2) == appended, "Appends go after the new tail\n");
+
+        ParseTreeDeinit(&context.tree, parent);
+}
+
+/* Heap and arena trees can share a context; each node is freed the way it was allocated. */
+void TestMixedTrees() {
+        char *source = "int main() { return 0; }";
+
+        gs_Buffer buffer;
+        gs_BufferInit(&buffer, source, gs_StringLength(source));
+        buffer.length = buffer.capacity;
+
+        ParseTreeNode *heap_tree = ParseTreeInit(&context.tree);
+        ParseTreeNode *arena_tree;
+        Tokenizer tokenizer;
+        GSTestAssert(Parse(&context, &buffer, &arena_tree, &tokenizer) == true, "Result should be true\n");
+
+        ParseTreeNode *heap_child = ParseTreeAddChild(&context.tree, heap_tree);
+        ParseTreeNode *arena_child = ParseTreeAddChild(&context.tree, arena_tree);
+        GSTestAssert(!heap_child->in_arena, "Heap trees grow on the heap\n");
+        GSTestAssert(arena_child->in_arena, "Arena trees grow in the arena\n");
+
+        ParseTreeDeinit(&context.tree, arena_tree);
+
+        ParseTreeNode *heap_grandchild = ParseTreeAddChild(&context.tree, heap_child);
+        GSTestAssert(!heap_grandchild->in_arena, "Heap trees outlive the arena\n");
+        GSTestAssert(gs_TreeNumChildren(&heap_tree->tree) == 1, "Heap tree keeps its child\n");
+
+        ParseTreeDeinit(&context.tree, heap_tree);
+}
+
+/* Memoized parsing must produce exactly the tree plain backtracking does. */
+void TestMemoization() {
+        char *sources[] = {
+                "int global = 1; int main(){}",
+                "static const unsigned long *f(a, b) int a; char *b; { return (long)sizeof(int) * -a + b[2]; }",
+                "int x = (1 ? 2 : 3), y; int main() { x = y = (int)*&x; }",
+                "int y = ((a + (b)) * ((int)c)) - sizeof (d) << ((e));",
+        };
+
+        for (int i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+                gs_Buffer buffer;
+                gs_BufferInit(&buffer, sources[i], gs_StringLength(sources[i]));
+                buffer.length = buffer.capacity;
+
+                ParseTreeNode *plain_tree, *memo_tree;
+                Tokenizer plain_tokenizer, memo_tokenizer;
+
+                ParserSetMemoization(&context, false);
+                bool plain_result = Parse(&context, &buffer, &plain_tree, &plain_tokenizer);
+                ParserSetMemoization(&context, true);
+                bool memo_result = Parse(&context, &buffer, &memo_tree, &memo_tokenizer);
+                ParserSetMemoization(&context, false);
+
+                GSTestAssert(plain_result == true, "Result should be true\n");
+                GSTestAssert(memo_result == plain_result, "Memoized result matches\n");
+                GSTestAssert(memo_tokenizer.at == plain_tokenizer.at, "Memoized parse ends at the same position\n");
+                GSTestAssert(TreesMatch(memo_tree, plain_tree), "Memoized parse tree matches\n");
+
+                ParseTreeDeinit(&context.tree, plain_tree);
+                ParseTreeDeinit(&context.tree, memo_tree);
+        }
+}
+
+u64 counted_bytes;
+
+void *CountingMalloc(u64 size) {
+        counted_bytes += size;
+        return malloc(size);
+}
+
+void *CountingRealloc(void *ptr, u64 size) {
+        counted_bytes += size;
+        return realloc(ptr, size);
+}
+
+void *CountingCalloc(u64 count, u64 size) {
+        counted_bytes += count * size;
+        return calloc(count, size);
+}
+
+/* Bytes allocated to parse `int x = ((...1...));' nested `depth' deep with memoization. */
+u64 MemoizedParseBytes(u32 depth) {
+        char *source = (char *)allocator.malloc(depth * 2 + 16);
+        u32 length = 0;
+        length += sprintf(source + length, "int x = ");
+        for (u32 i = 0; i < depth; i++) source[length++] = '(';
+        source[length++] = '1';
+        for (u32 i = 0; i < depth; i++) source[length++] = ')';
+        length += sprintf(source + length, ";");
+
+        gs_Buffer buffer;
+        gs_BufferInit(&buffer, source, length);
+        buffer.length = buffer.capacity;
+
+        gs_Allocator counting = { .malloc = CountingMalloc, .free = free, .realloc = CountingRealloc, .calloc = CountingCalloc };
+        ParserContext counted;
+        ParserContextInit(&counted, counting);
+        ParserSetMemoization(&counted, true);
+
+        ParseTreeNode *tree;
+        Tokenizer tokenizer;
+        counted_bytes = 0;
+        bool result = Parse(&counted, &buffer, &tree, &tokenizer);
+        u64 bytes = counted_bytes;
+        GSTestAssert(result == true, "Result should be true\n");
+
+        ParseTreeDeinit(&counted.tree, tree);
+        ParserContextDeinit(&counted);
+        allocator.free(source);
+
+        return bytes;
+}
+
+/* Retried rules reuse their subtree, so memory grows linearly with nesting depth. */
+void TestMemoizationScaling() {
+        u64 shallow = MemoizedParseBytes(200);
+        u64 deep = MemoizedParseBytes(800);
+        GSTestAssert(deep < shallow * 8, "Memoized parse memory is linear in depth\n");
+}
+
+bool FlatTreeMatches(ParseFlatTree *flat, u32 node, ParseTreeNode *tree) {
+        if (node == PARSE_FLAT_TREE_NONE || tree == GS_NULL_PTR) {
+                return node == PARSE_FLAT_TREE_NONE && tree == GS_NULL_PTR;
+        }
+        if (flat->kind[node] != tree->type) return false;
+
+        u32 token_index = flat->token_index[node];
+        if (tree->token.type == Token_Unknown) {
+                if (token_index != PARSE_FLAT_TREE_NONE) return false;
+        } else if (token_index == PARSE_FLAT_TREE_NONE || TokenStreamGet(&flat->tokens, token_index).text != tree->token.text) {
+                return false;
+        }
+
+        ParseTreeNode *child = (tree->tree.child == GS_NULL_PTR) ? GS_NULL_PTR : gs_TreeContainer(tree->tree.child, ParseTreeNode, tree);
+        ParseTreeNode *sibling = (tree->tree.sibling == GS_NULL_PTR) ? GS_NULL_PTR : gs_TreeContainer(tree->tree.sibling, ParseTreeNode, tree);
+
+        return FlatTreeMatches(flat, flat->first_child[node], child) &&
+               FlatTreeMatches(flat, flat->next_sibling[node], sibling);
+}
+
+/* The flat layout must describe exactly the tree Parse builds, with the same options. */
+void TestFlatTree() {
+        char *source = "typedef int my_type; my_type f(int a) { if (a) return (my_type)a * 2; return -1; }\n"
+                       "int x[2] = { 1, 2 }; struct s { int y; } z; int g(void) { return x[0] + z.y; }";
+
+        gs_Buffer buffer;
+        gs_BufferInit(&buffer, source, gs_StringLength(source));
+        buffer.length = buffer.capacity;
+
+        for (int options = 0; options < 4; options++) {
+                ParserSetMemoization(&context, (options & 1) != 0);
+                ParserSetCompaction(&context, (options & 2) != 0);
+
+                ParseTreeNode *tree;
+                ParseFlatTree flat;
+                Tokenizer tokenizer, flat_tokenizer;
+
+                GSTestAssert(Parse(&context, &buffer, &tree, &tokenizer) == true, "Result should be true\n");
+                GSTestAssert(ParseFlat(&context, &buffer, &flat, &flat_tokenizer) == true, "Result should be true\n");
+                GSTestAssert(flat_tokenizer.at == tokenizer.at, "Flat parse ends at the same position\n");
+                GSTestAssert(flat.num_nodes == __ParseFlatTreeCount(tree), "Flat tree has every node\n");
+                GSTestAssert(FlatTreeMatches(&flat, 0, tree), "Flat tree matches the pointer tree\n");
+                for (u32 i = 0; i < flat.num_nodes; i++) {
+                        u32 child = flat.first_child[i];
+                        GSTestAssert(child == PARSE_FLAT_TREE_NONE || child == i + 1, "Nodes are in pre-order\n");
+                }
+
+                ParseFlatTreeDeinit(&flat);
+                ParseTreeDeinit(&context.tree, tree);
+        }
+
+        ParserSetMemoization(&context, false);
+        ParserSetCompaction(&context, false);
+}
+
+u32 allocations_left;
+
+void *FailingMalloc(u64 size) {
+        if (allocations_left == 0) return GS_NULL_PTR;
+        allocations_left--;
+        return malloc(size);
+}
+
+void *FailingRealloc(void *ptr, u64 size) {
+        if (allocations_left == 0) return GS_NULL_PTR;
+        allocations_left--;
+        return realloc(ptr, size);
+}
+
+void *FailingCalloc(u64 count, u64 size) {
+        if (allocations_left == 0) return GS_NULL_PTR;
+        allocations_left--;
+        return calloc(count, size);
+}
+
+/* Running out of memory at any point fails the parse and frees what it had. */
+void TestFlatTreeOutOfMemory() {
+        char *source = "int x[2] = { 1, 2 }; int f(int a) { return x[a] * 2; }";
+
+        gs_Buffer buffer;
+        gs_BufferInit(&buffer, source, gs_StringLength(source));
+        buffer.length = buffer.capacity;
+
+        gs_Allocator failing = { .malloc = FailingMalloc, .free = free, .realloc = FailingRealloc, .calloc = FailingCalloc };
+        bool result = false;
+        for (u32 limit = 0; !result; limit++) {
+                ParserContext limited;
+                ParserContextInit(&limited, failing);
+                ParserSetCompaction(&limited, true);
+
+                ParseFlatTree flat;
+                Tokenizer tokenizer;
+                allocations_left = limit;
+                result = ParseFlat(&limited, &buffer, &flat, &tokenizer);
+                allocations_left = 0xFFFFFFFF;
+                if (result) ParseFlatTreeDeinit(&flat);
+
+                ParserContextDeinit(&limited);
+        }
+
+        ParserContext limited;
+        ParserContextInit(&limited, failing);
+        ParseTreeNode *tree;
+        Tokenizer tokenizer;
+        allocations_left = 0;
+        result = Parse(&limited, &buffer, &tree, &tokenizer);
+        allocations_left = 0xFFFFFFFF;
+        GSTestAssert(!result && tree == GS_NULL_PTR, "Parse fails without a tree\n");
+        GSTestAssert(limited.tree.last_error == ParseTreeErrorRootAlloc, "The tree allocation failure is recorded\n");
+        ParseTreeDeinit(&limited.tree, tree);
+        ParserContextDeinit(&limited);
+}
+
+/* Collects the tokens of every node below self in pre-order. */
+u32 CollectTokens(ParseTreeNode *self, char **texts, u32 count) {
+        for (gs_TreeNode *child = self->tree.child; child != GS_NULL_PTR; child = child->sibling) {
+                ParseTreeNode *node = gs_TreeContainer(child, ParseTreeNode, tree);
+                if (node->token.type != Token_Unknown) texts[count++] = node->token.text;
+                count = CollectTokens(node, texts, count);
+        }
+        return count;
+}
+
+bool IsCompact(ParseTreeNode *self) {
+        for (gs_TreeNode *child = self->tree.child; child != GS_NULL_PTR; child = child->sibling) {
+                ParseTreeNode *node = gs_TreeContainer(child, ParseTreeNode, tree);
+                u32 num_children = gs_TreeNumChildren(&node->tree);
+                if (node->type == ParseTreeNode_Unknown) return false;
+                if (ParseTreeNodeIsTail(node->type) && num_children == 0) return false;
+                if (node->token.type == Token_Unknown && num_children == 1) return false;
+                if (!IsCompact(node)) return false;
+        }
+        return true;
+}
+
+/* Compaction keeps every token, in order, and leaves no removable node behind. */
+void TestCompaction() {
+        char *source = "int a[2] = { 1, 2 }; int main(int argc) { for (;;) { a[0] = -a[1] + argc; } return a[0]; }";
+
+        gs_Buffer buffer;
+        gs_BufferInit(&buffer, source, gs_StringLength(source));
+        buffer.length = buffer.capacity;
+
+        ParseTreeNode *plain_tree, *compact_tree;
+        Tokenizer tokenizer;
+        char *plain_tokens[128], *compact_tokens[128];
+
+        GSTestAssert(Parse(&context, &buffer, &plain_tree, &tokenizer) == true, "Result should be true\n");
+        ParserSetCompaction(&context, true);
+        GSTestAssert(Parse(&context, &buffer, &compact_tree, &tokenizer) == true, "Result should be true\n");
+        ParserSetCompaction(&context, false);
+
+        u32 num_plain = CollectTokens(plain_tree, plain_tokens, 0);
+        u32 num_compact = CollectTokens(compact_tree, compact_tokens, 0);
+        GSTestAssert(num_compact == num_plain, "Compaction keeps every token\n");
+        for (u32 i = 0; i < num_plain; i++) {
+                GSTestAssert(compact_tokens[i] == plain_tokens[i], "Compaction keeps token order\n");
+        }
+        GSTestAssert(IsCompact(compact_tree), "Compacted tree has no removable nodes\n");
+        GSTestAssert(compact_tree->type == ParseTreeNode_TranslationUnit, "Root keeps its type\n");
+
+        ParseTreeDeinit(&context.tree, plain_tree);
+        ParseTreeDeinit(&context.tree, compact_tree);
+}
+
+typedef struct ContextThread {
+        gs_Buffer *buffer;
+        ParseFlatTree *reference;
+        bool memoize;
+        bool matched;
+} ContextThread;
+
+bool FlatTreesMatch(ParseFlatTree *a, ParseFlatTree *b) {
+        if (a->num_nodes != b->num_nodes) return false;
+        for (u32 i = 0; i < a->num_nodes; i++) {
+                if (a->kind[i] != b->kind[i] || a->token_index[i] != b->token_index[i]) return false;
+                if (a->first_child[i] != b->first_child[i] || a->next_sibling[i] != b->next_sibling[i]) return false;
+        }
+        return true;
+}
+
+void *ParseOnThread(void *data) {
+        ContextThread *thread = (ContextThread *)data;
+        ParserContext thread_context;
+        ParserContextInit(&thread_context, allocator);
+        ParserSetMemoization(&thread_context, thread->memoize);
+
+        thread->matched = true;
+        for (u32 i = 0; i < 16; i++) {
+                ParseFlatTree flat;
+                Tokenizer tokenizer;
+                if (!ParseFlat(&thread_context, thread->buffer, &flat, &tokenizer)) {
+                        thread->matched = false;
+                        break;
+                }
+                thread->matched = thread->matched && FlatTreesMatch(&flat, thread->reference);
+                ParseFlatTreeDeinit(&flat);
+        }
+
+        ParserContextDeinit(&thread_context);
+        return GS_NULL_PTR;
+}
+
+/* Separate contexts share no state, so they can parse concurrently. */
+void TestParserContext() {
+        ParserContext a, b;
+        ParserContextInit(&a, allocator);
+        ParserContextInit(&b, allocator);
+
+        TypedefAddName(&a, "my_type");
+        Tokenizer tokenizer = InitTokenizer("my_type", 0);
+        ParseTreeNode *tree = ParseTreeInit(&a.tree);
+        GSTestAssert(ParseTypedefName(&a, &tokenizer, tree) == true, "Typedef name is known to its context\n");
+        ParseTreeDeinit(&a.tree, tree);
+        tokenizer = InitTokenizer("my_type", 0);
+        tree = ParseTreeInit(&b.tree);
+        GSTestAssert(ParseTypedefName(&b, &tokenizer, tree) == false, "Typedef name is unknown to other contexts\n");
+        ParseTreeDeinit(&b.tree, tree);
+
+        char *bad_source = "int `";
+        gs_Buffer bad_buffer;
+        gs_BufferInit(&bad_buffer, bad_source, gs_StringLength(bad_source));
+        bad_buffer.length = bad_buffer.capacity;
+        Token *tokens;
+        u32 num_tokens;
+        GSTestAssert(Lex(&a.lexer, &bad_buffer, &tokens, &num_tokens) == true, "Result should be true\n");
+        GSTestAssert(tokens[num_tokens - 1].type == Token_Unknown, "Lexing stops at the bad token\n");
+        GSTestAssert(a.lexer.last_error == LexerUnknownToken, "Error is recorded in its context\n");
+        GSTestAssert(b.lexer.last_error == LexerErrorNone, "Other contexts see no error\n");
+        allocator.free(tokens);
+
+        ParserContextDeinit(&a);
+        ParserContextDeinit(&b);
+
+        char *source = "int a[2] = { 1, 2 }; struct s { int x; char *y; };\n"
+                       "int main(int argc, char **argv) { for (;;) { a[0] = -a[1] + argc; } return (int)a[0] * 2; }";
+        gs_Buffer buffer;
+        gs_BufferInit(&buffer, source, gs_StringLength(source));
+        buffer.length = buffer.capacity;
+
+        ParseFlatTree reference;
+        GSTestAssert(ParseFlat(&context, &buffer, &reference, &tokenizer) == true, "Result should be true\n");
+
+        ContextThread threads[4];
+        pthread_t handles[gs_ArraySize(threads)];
+        for (u32 i = 0; i < gs_ArraySize(threads); i++) {
+                threads[i] = (ContextThread){ .buffer = &buffer, .reference = &reference, .memoize = (i % 2 == 1) };
+                GSTestAssert(pthread_create(&handles[i], GS_NULL_PTR, ParseOnThread, &threads[i]) == 0, "Thread should start\n");
+        }
+        for (u32 i = 0; i < gs_ArraySize(threads); i++) {
+                pthread_join(handles[i], GS_NULL_PTR);
+                GSTestAssert(threads[i].matched, "Concurrent parses match the reference\n");
+        }
+
+        ParseFlatTreeDeinit(&reference);
+}
+
 /*----------------------------------------------------------------------------
   Main Entrypoint
   ----------------------------------------------------------------------------*/
 
 int main(int ArgCount, char **Arguments) {
-        gs_args Args;
-        GSArgsInit(&Args, ArgCount, Arguments);
-
-        if(GSArgsHelpWanted(&Args))
-        {
+        if (ArgCount > 1) {
                 printf("Executable tests\n\n");
-                printf("Usage: run\n");
+                printf("Usage: test\n");
                 printf("  Specify '-h' or '--help' for this help text.\n");
                 exit(EXIT_SUCCESS);
         }
 
+        ParserContextInit(&context, allocator);
+
+        TestGetToken();
+        TestTokenStream();
+        TestLexParallel();
+        TestLexerStream();
+        TestLexerStreamOneLine();
+        TestLexEdit();
+        TestLexerSymbols();
+        TestLexerValues();
+        TestLexerTrivia();
+        TestLexerDiagnostics();
         TestConstant();
         TestArgumentExpressionList();
         TestUnaryExpression();
@@ -640,7 +1817,17 @@ int main(int ArgCount, char **Arguments) {
         TestFunctionDefinition();
         TestExternalDeclaration();
         TestTranslationUnit();
-
+        TestArena();
+        TestTreeChildren();
+        TestMixedTrees();
+        TestMemoization();
+        TestMemoizationScaling();
+        TestFlatTree();
+        TestFlatTreeOutOfMemory();
+        TestCompaction();
+        TestParserContext();
+
+        ParserContextDeinit(&context);
         printf("All tests successful\n");
 
         return EXIT_SUCCESS;
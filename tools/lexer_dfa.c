@@ -0,0 +1,294 @@
+/******************************************************************************
+ * File: lexer_dfa.c
+ * Created: 2026-10-18
+ * Updated: 2026-10-18
+ * Package: C-Parser
+ * Creator: Aaron Oman (GrooveStomp)
+ * Homepage: https://git.sr.ht/~groovestomp/c-parser
+ * Copyright 2016 - 2026, Aaron Oman and the C-Parser contributors
+ * SPDX-License-Identifier: LGPL-3.0-only
+ ******************************************************************************/
+/*
+  Host tool: compiles the token grammar below into the DFA tables that
+  GetToken() in src/lexer.c runs, and writes them to standard output as a C
+  header. `make dfa' regenerates src/lexer_dfa.h with it.
+
+  A rule is a sequence of byte sets, optionally followed by a set that may
+  repeat, and what the lexer does when it ends there: either a token of that
+  length, or a scanner action for tokens with bodies (comments, strings,
+  numbers, ...) that starts over at the token's first byte, with a
+  one-byte fallback token if the scanner doesn't take it.
+
+  Rules form a trie over byte sets, so the DFA is built directly; two rules
+  that reach the same byte through different states are a grammar error.
+  Bytes that every state treats alike share an equivalence class, so the
+  transition table has one column per class rather than per byte.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned char u8;
+
+#define MAX_STATES 256
+#define MAX_STEPS 4
+#define DEAD 0
+#define START 1
+
+typedef struct Rule {
+        const char *steps[MAX_STEPS]; /* Byte sets; `a-z' is a range. */
+        const char *repeat; /* Optional set that loops at the end. */
+        const char *token; /* TokenType when the rule ends here, or the fallback for `action'. */
+        const char *action; /* LexerAction, or null for a plain token. */
+} Rule;
+
+#define LETTERS "a-zA-Z_"
+#define DIGITS "0-9"
+
+static const Rule rules[] = {
+        /* End of input: the terminating NUL, written as an empty set. */
+        { { "" }, NULL, "Token_EndOfStream", NULL },
+
+        /* Punctuators. */
+        { { "(" }, NULL, "Token_OpenParen", NULL },
+        { { ")" }, NULL, "Token_CloseParen", NULL },
+        { { "[" }, NULL, "Token_OpenBracket", NULL },
+        { { "]" }, NULL, "Token_CloseBracket", NULL },
+        { { "{" }, NULL, "Token_OpenBrace", NULL },
+        { { "}" }, NULL, "Token_CloseBrace", NULL },
+        { { ":" }, NULL, "Token_Colon", NULL },
+        { { ";" }, NULL, "Token_SemiColon", NULL },
+        { { "," }, NULL, "Token_Comma", NULL },
+        { { "?" }, NULL, "Token_QuestionMark", NULL },
+        { { "~" }, NULL, "Token_Tilde", NULL },
+        { { "." }, NULL, "Token_Dot", NULL },
+        { { ".", ".", "." }, NULL, "Token_Ellipsis", NULL },
+
+        /* Operators. */
+        { { "=" }, NULL, "Token_EqualSign", NULL },
+        { { "=", "=" }, NULL, "Token_LogicalEqual", NULL },
+        { { "!" }, NULL, "Token_Bang", NULL },
+        { { "!", "=" }, NULL, "Token_NotEqual", NULL },
+        { { "<" }, NULL, "Token_LessThan", NULL },
+        { { "<", "=" }, NULL, "Token_LessThanEqual", NULL },
+        { { "<", "<" }, NULL, "Token_BitShiftLeft", NULL },
+        { { "<", "<", "=" }, NULL, "Token_DoubleLessThanEquals", NULL },
+        { { ">" }, NULL, "Token_GreaterThan", NULL },
+        { { ">", "=" }, NULL, "Token_GreaterThanEqual", NULL },
+        { { ">", ">" }, NULL, "Token_BitShiftRight", NULL },
+        { { ">", ">", "=" }, NULL, "Token_DoubleGreaterThanEquals", NULL },
+        { { "|" }, NULL, "Token_Pipe", NULL },
+        { { "|", "=" }, NULL, "Token_PipeEquals", NULL },
+        { { "|", "|" }, NULL, "Token_LogicalOr", NULL },
+        { { "&" }, NULL, "Token_Ampersand", NULL },
+        { { "&", "=" }, NULL, "Token_AmpersandEquals", NULL },
+        { { "&", "&" }, NULL, "Token_LogicalAnd", NULL },
+        { { "+" }, NULL, "Token_Cross", NULL },
+        { { "+", "=" }, NULL, "Token_PlusEquals", NULL },
+        { { "+", "+" }, NULL, "Token_PlusPlus", NULL },
+        { { "-" }, NULL, "Token_Dash", NULL },
+        { { "-", "=" }, NULL, "Token_MinusEquals", NULL },
+        { { "-", "-" }, NULL, "Token_MinusMinus", NULL },
+        { { "-", ">" }, NULL, "Token_Arrow", NULL },
+        { { "*" }, NULL, "Token_Asterisk", NULL },
+        { { "*", "=" }, NULL, "Token_MultiplyEquals", NULL },
+        { { "/" }, NULL, "Token_Slash", NULL },
+        { { "/", "=" }, NULL, "Token_DivideEquals", NULL },
+        { { "%" }, NULL, "Token_PercentSign", NULL },
+        { { "%", "=" }, NULL, "Token_ModuloEquals", NULL },
+        { { "^" }, NULL, "Token_Carat", NULL },
+        { { "^", "=" }, NULL, "Token_CaratEquals", NULL },
+
+        /* Identifiers and keywords; the action tells them apart. */
+        { { LETTERS }, LETTERS DIGITS, "Token_Identifier", "LexerAction_Word" },
+
+        /* Tokens with bodies, handed to their scanners. */
+        { { DIGITS }, NULL, "Token_Unknown", "LexerAction_Number" },
+        { { ".", DIGITS }, NULL, "Token_Dot", "LexerAction_Fraction" },
+        { { "'" }, NULL, "Token_Unknown", "LexerAction_Character" },
+        { { "\"" }, NULL, "Token_Unknown", "LexerAction_String" },
+        { { "#" }, NULL, "Token_Hash", "LexerAction_Directive" },
+        { { "/", "*" }, NULL, "Token_Slash", "LexerAction_Comment" },
+};
+
+#define NUM_RULES (sizeof(rules) / sizeof(rules[0]))
+
+typedef struct State {
+        int next[256];
+        const char *token;
+        const char *action;
+        int rule; /* Rule accepting here, or -1. */
+} State;
+
+static State states[MAX_STATES];
+static int num_states;
+
+static void Fail(const char *message, int rule) {
+        fprintf(stderr, "lexer_dfa: %s (rule %d)\n", message, rule);
+        exit(EXIT_FAILURE);
+}
+
+static int NewState(void) {
+        if (num_states == MAX_STATES) Fail("too many states", -1);
+        State *state = &states[num_states];
+        memset(state->next, 0, sizeof(state->next));
+        state->token = NULL;
+        state->action = NULL;
+        state->rule = -1;
+        return num_states++;
+}
+
+/* Expands a set like "a-zA-Z_" into a 256-entry membership table. */
+static void ExpandSet(const char *set, u8 *members) {
+        memset(members, 0, 256);
+        if (set[0] == '\0') {
+                members[0] = 1;
+                return;
+        }
+        for (const char *c = set; *c != '\0'; c++) {
+                if (c[1] == '-' && c[2] != '\0') {
+                        for (int b = (u8)c[0]; b <= (u8)c[2]; b++) members[b] = 1;
+                        c += 2;
+                } else {
+                        members[(u8)*c] = 1;
+                }
+        }
+}
+
+/* Follows or creates the edges for `set' out of `from'; every byte must land on the same state. */
+static int Step(int from, const char *set, int rule) {
+        u8 members[256];
+        ExpandSet(set, members);
+
+        int to = DEAD;
+        for (int b = 0; b < 256; b++) {
+                if (!members[b]) continue;
+                int existing = states[from].next[b];
+                if (to == DEAD) to = existing;
+                if (existing != to) Fail("a set's bytes lead to different states", rule);
+        }
+        if (to == DEAD) to = NewState();
+
+        for (int b = 0; b < 256; b++) {
+                if (members[b]) states[from].next[b] = to;
+        }
+        return to;
+}
+
+static void AddRule(int index) {
+        const Rule *rule = &rules[index];
+        int state = START;
+        for (int i = 0; i < MAX_STEPS && rule->steps[i] != NULL; i++) {
+                state = Step(state, rule->steps[i], index);
+        }
+        if (rule->repeat != NULL) {
+                u8 members[256];
+                ExpandSet(rule->repeat, members);
+                for (int b = 0; b < 256; b++) {
+                        if (!members[b]) continue;
+                        if (states[state].next[b] != DEAD && states[state].next[b] != state) Fail("repeat overlaps another rule", index);
+                        states[state].next[b] = state;
+                }
+        }
+
+        if (states[state].rule >= 0) Fail("two rules end in the same state", index);
+        states[state].rule = index;
+        states[state].token = rule->token;
+        states[state].action = rule->action;
+}
+
+static int IsFinal(int state) {
+        for (int b = 0; b < 256; b++) {
+                if (states[state].next[b] != DEAD) return 0;
+        }
+        return 1;
+}
+
+int main(void) {
+        NewState(); /* DEAD */
+        NewState(); /* START */
+        for (int i = 0; i < (int)NUM_RULES; i++) AddRule(i);
+
+        /* The terminating NUL must stop every state. */
+        for (int s = 0; s < num_states; s++) {
+                if (s != START && states[s].next[0] != DEAD) Fail("a rule continues past the end of input", -1);
+        }
+
+        /*
+          Renumber: the dead state, the start state, states with edges out,
+          then final states, so the lexer stops on `state >= first final'.
+        */
+        int order[MAX_STATES], number[MAX_STATES];
+        int num_ordered = 0;
+        order[num_ordered++] = DEAD;
+        order[num_ordered++] = START;
+        for (int s = START + 1; s < num_states; s++) {
+                if (!IsFinal(s)) order[num_ordered++] = s;
+        }
+        int first_final = num_ordered;
+        for (int s = START + 1; s < num_states; s++) {
+                if (IsFinal(s)) order[num_ordered++] = s;
+        }
+        for (int i = 0; i < num_states; i++) number[order[i]] = i;
+
+        /* Equivalence classes: bytes with identical columns. */
+        int byte_class[256];
+        int class_byte[256];
+        int num_classes = 0;
+        for (int b = 0; b < 256; b++) {
+                byte_class[b] = -1;
+                for (int k = 0; k < num_classes && byte_class[b] < 0; k++) {
+                        int same = 1;
+                        for (int s = 0; s < num_states && same; s++) {
+                                same = states[s].next[b] == states[s].next[class_byte[k]];
+                        }
+                        if (same) byte_class[b] = k;
+                }
+                if (byte_class[b] < 0) {
+                        class_byte[num_classes] = b;
+                        byte_class[b] = num_classes++;
+                }
+        }
+
+        printf("/* Generated by tools/lexer_dfa.c; do not edit. Run `make dfa' to regenerate. */\n");
+        printf("#ifndef LEXER_DFA_H\n#define LEXER_DFA_H\n\n");
+        printf("#define LEXER_DFA_DEAD 0\n");
+        printf("#define LEXER_DFA_START 1\n");
+        printf("#define LEXER_DFA_FIRST_FINAL %d\n", first_final);
+        printf("#define LEXER_DFA_NUM_STATES %d\n", num_states);
+        printf("#define LEXER_DFA_NUM_CLASSES %d\n\n", num_classes);
+
+        printf("static const u8 __lexer_dfa_classes[256] = {");
+        for (int b = 0; b < 256; b++) printf("%s%d,", (b % 16 == 0) ? "\n        " : " ", byte_class[b]);
+        printf("\n};\n\n");
+
+        printf("static const u8 __lexer_dfa_next[LEXER_DFA_NUM_STATES][LEXER_DFA_NUM_CLASSES] = {\n");
+        for (int i = 0; i < num_states; i++) {
+                printf("        {");
+                for (int k = 0; k < num_classes; k++) {
+                        printf("%s%d", (k == 0) ? " " : ", ", number[states[order[i]].next[class_byte[k]]]);
+                }
+                printf(" },\n");
+        }
+        printf("};\n\n");
+
+        printf("/* The token a state accepts, or the one-byte fallback if its action's scanner fails. */\n");
+        printf("static const u8 __lexer_dfa_token[LEXER_DFA_NUM_STATES] = {\n");
+        for (int i = 0; i < num_states; i++) {
+                const char *token = states[order[i]].token;
+                printf("        %s,\n", (token != NULL) ? token : "Token_Unknown");
+        }
+        printf("};\n\n");
+
+        printf("static const u8 __lexer_dfa_action[LEXER_DFA_NUM_STATES] = {\n");
+        for (int i = 0; i < num_states; i++) {
+                const State *state = &states[order[i]];
+                const char *action = (state->action != NULL) ? state->action :
+                                     (state->rule >= 0) ? "LexerAction_Token" : "LexerAction_None";
+                printf("        %s,\n", action);
+        }
+        printf("};\n\n");
+
+        printf("#endif /* LEXER_DFA_H */\n");
+        return EXIT_SUCCESS;
+}